@@ -0,0 +1,147 @@
+#include "accounting.h"
+#include <cstddef>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <new>
+#include <string>
+
+#ifdef TESTER_ALLOCATIONS
+namespace {
+	// Placed before every block, the size keeps the block aligned as operator new has to
+	struct alignas ( alignof ( std::max_align_t ) ) Header {
+		Accounting::Counters* Owner;
+		size_t Size;
+	};
+
+	Accounting::Counters Process {};
+	thread_local Accounting::Counters* Current { nullptr };
+
+	void add ( Accounting::Counters& Tag, size_t Size ) {
+		Tag.Allocations.fetch_add ( 1, std::memory_order_relaxed );
+		Tag.Bytes.fetch_add ( Size, std::memory_order_relaxed );
+		auto live = Tag.Live.fetch_add ( Size, std::memory_order_relaxed ) + Size;
+		auto peak = Tag.Peak.load ( std::memory_order_relaxed );
+		while ( live > peak && !Tag.Peak.compare_exchange_weak ( peak, live, std::memory_order_relaxed ) ) {}
+	}
+
+	void remove ( Accounting::Counters& Tag, size_t Size ) {
+		Tag.Frees.fetch_add ( 1, std::memory_order_relaxed );
+		Tag.Live.fetch_sub ( Size, std::memory_order_relaxed );
+	}
+
+	void* allocate ( size_t Size ) noexcept {
+		while ( true ) {
+			if ( auto header = static_cast<Header*> ( std::malloc ( sizeof ( Header ) + Size ) ) ) {
+				header->Owner = Current;
+				header->Size = Size;
+				add ( Process, Size );
+				if ( Current ) {
+					add ( *Current, Size );
+				}
+				return header + 1;
+			}
+			auto handler = std::get_new_handler ();
+			if ( !handler ) {
+				return nullptr;
+			}
+			handler ();
+		}
+	}
+
+	void release ( void* Pointer ) noexcept {
+		if ( !Pointer ) {
+			return;
+		}
+		auto header = static_cast<Header*> ( Pointer ) - 1;
+		remove ( Process, header->Size );
+		if ( header->Owner ) {
+			remove ( *header->Owner, header->Size );
+		}
+		std::free ( header );
+	}
+
+	void* allocateOrThrow ( size_t Size ) {
+		if ( auto result = allocate ( Size ) ) {
+			return result;
+		}
+		throw std::bad_alloc ();
+	}
+}
+
+// The module carries its own C++ runtime and is linked with -Bsymbolic, see CMakeLists.txt, so all of it
+// allocates here, the standard library too, while the rest of the process keeps its allocator
+void* operator new ( size_t Size ) {
+	return allocateOrThrow ( Size );
+}
+
+void* operator new[] ( size_t Size ) {
+	return allocateOrThrow ( Size );
+}
+
+void* operator new ( size_t Size, const std::nothrow_t& ) noexcept {
+	return allocate ( Size );
+}
+
+void* operator new[] ( size_t Size, const std::nothrow_t& ) noexcept {
+	return allocate ( Size );
+}
+
+void operator delete ( void* Pointer ) noexcept {
+	release ( Pointer );
+}
+
+void operator delete[] ( void* Pointer ) noexcept {
+	release ( Pointer );
+}
+
+void operator delete ( void* Pointer, size_t ) noexcept {
+	release ( Pointer );
+}
+
+void operator delete[] ( void* Pointer, size_t ) noexcept {
+	release ( Pointer );
+}
+
+void operator delete ( void* Pointer, const std::nothrow_t& ) noexcept {
+	release ( Pointer );
+}
+
+void operator delete[] ( void* Pointer, const std::nothrow_t& ) noexcept {
+	release ( Pointer );
+}
+
+Accounting::Scope::Scope ( Counters* Tag ) : Previous ( Current ) {
+	Current = Tag;
+}
+
+Accounting::Scope::~Scope () {
+	Current = Previous;
+}
+
+Accounting::Counters* Accounting::Tag ( std::wstring_view Component, std::wstring_view Method ) {
+	// Left to leak, blocks freed while the module unloads still point at their counters
+	static auto tags = new std::map<std::wstring, Counters, std::less<>> ();
+	static std::mutex lock;
+	Scope untagged ( nullptr );
+	std::wstring name { Component };
+	name.append ( L"." ).append ( Method );
+	std::lock_guard<std::mutex> guard ( lock );
+	return &( *tags )[ name ];
+}
+
+Accounting::Summary Accounting::Summarize ( const Counters* Tag ) {
+	auto& tag = Tag ? *Tag : Process;
+	return { tag.Allocations.load ( std::memory_order_relaxed ), tag.Frees.load ( std::memory_order_relaxed ),
+			 tag.Bytes.load ( std::memory_order_relaxed ), tag.Live.load ( std::memory_order_relaxed ),
+			 tag.Peak.load ( std::memory_order_relaxed ) };
+}
+#else
+Accounting::Counters* Accounting::Tag ( std::wstring_view, std::wstring_view ) {
+	return nullptr;
+}
+
+Accounting::Summary Accounting::Summarize ( const Counters* ) {
+	return {};
+}
+#endif
@@ -0,0 +1,58 @@
+#ifndef __accounting_h__
+#define __accounting_h__
+#include <atomic>
+#include <cstdint>
+#include <string_view>
+
+// Heap use of the component, built with TESTER_ALLOCATIONS only. The module then has its own operator new
+// and delete, which only the module itself calls, that keep the size and the owner of every block in
+// front of it. The owner is the tag of the Scope the thread was in, so a block freed by someone else
+// later is still taken off the counters it was added to. Without the option Scope does nothing
+class Accounting {
+public:
+	struct Counters {
+		std::atomic<uint64_t> Allocations;
+		std::atomic<uint64_t> Frees;
+		std::atomic<uint64_t> Bytes;
+		std::atomic<uint64_t> Live;
+		std::atomic<uint64_t> Peak;
+	};
+
+	struct Summary {
+		uint64_t Allocations;
+		uint64_t Frees;
+		uint64_t Bytes;
+		uint64_t Live;
+		uint64_t Peak;
+	};
+
+	// Allocations on this thread go to Tag until the scope ends, a null tag to the process only
+	class Scope {
+	public:
+#ifdef TESTER_ALLOCATIONS
+		explicit Scope ( Counters* Tag );
+		~Scope ();
+#else
+		explicit Scope ( Counters* ) {}
+#endif
+		Scope ( const Scope& ) = delete;
+		Scope& operator= ( const Scope& ) = delete;
+#ifdef TESTER_ALLOCATIONS
+	private:
+		Counters* Previous;
+#endif
+	};
+
+#ifdef TESTER_ALLOCATIONS
+	static constexpr bool Enabled { true };
+#else
+	static constexpr bool Enabled { false };
+#endif
+
+	// Counters of a component method, or of the component itself for an empty Method. They are never freed,
+	// blocks outlive components, and every instance of the component shares them
+	static Counters* Tag ( std::wstring_view Component, std::wstring_view Method );
+	// The whole module for a null Tag
+	static Summary Summarize ( const Counters* Tag );
+};
+#endif
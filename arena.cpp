@@ -0,0 +1,84 @@
+#include "arena.h"
+#include <algorithm>
+#include <atomic>
+
+namespace {
+	std::atomic<uint64_t> avoided { 0 };
+}
+
+Arena::Scope::Scope () {
+	++Local ().Depth;
+}
+
+Arena::Scope::~Scope () {
+	auto& arena = Local ();
+	if ( !--arena.Depth ) {
+		arena.rewind ();
+	}
+}
+
+Arena& Arena::Local () {
+	thread_local Arena arena;
+	return arena;
+}
+
+uint64_t Arena::Avoided () {
+	return avoided.load ( std::memory_order_relaxed );
+}
+
+void* Arena::take ( size_t Bytes, size_t Alignment ) {
+	while ( Current < Chunks.size () ) {
+		auto& chunk = Chunks[ Current ];
+		void* position = chunk.Data.get () + Used;
+		auto space = chunk.Size - Used;
+		if ( std::align ( Alignment, Bytes, position, space ) ) {
+			Used = chunk.Size - space + Bytes;
+			return position;
+		}
+		++Current;
+		Used = 0;
+	}
+	return nullptr;
+}
+
+void* Arena::do_allocate ( size_t Bytes, size_t Alignment ) {
+	if ( auto result = take ( Bytes, Alignment ) ) {
+		avoided.fetch_add ( 1, std::memory_order_relaxed );
+		return result;
+	}
+	auto size = std::max ( Chunks.empty () ? Block : Chunks.back ().Size * 2, Bytes + Alignment );
+	Chunks.push_back ( { std::unique_ptr<std::byte[]> ( new std::byte[ size ] ), size } );
+	Current = Chunks.size () - 1;
+	Used = 0;
+	return take ( Bytes, Alignment );
+}
+
+// Only the latest allocation is given back, which lets a growing string or vector reuse its place
+void Arena::do_deallocate ( void* Pointer, size_t Bytes, size_t ) {
+	if ( Current < Chunks.size () ) {
+		auto base = Chunks[ Current ].Data.get ();
+		if ( static_cast<std::byte*> ( Pointer ) + Bytes == base + Used ) {
+			Used = static_cast<std::byte*> ( Pointer ) - base;
+		}
+	}
+}
+
+bool Arena::do_is_equal ( const std::pmr::memory_resource& Other ) const noexcept {
+	return this == &Other;
+}
+
+// A round that needed several blocks leaves one block of their total size, so the next such round fits
+void Arena::rewind () {
+	size_t total { 0 };
+	for ( auto& chunk : Chunks ) {
+		total += chunk.Size;
+	}
+	if ( total > Limit ) {
+		Chunks.clear ();
+	} else if ( Chunks.size () > 1 ) {
+		Chunks.clear ();
+		Chunks.push_back ( { std::unique_ptr<std::byte[]> ( new std::byte[ total ] ), total } );
+	}
+	Current = 0;
+	Used = 0;
+}
@@ -0,0 +1,47 @@
+#ifndef __arena_h__
+#define __arena_h__
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+// Per-thread bump allocator for buffers living no longer than one call into the component: argument
+// conversions, error texts, results being built. Nothing is freed one by one, the arena is rewound when
+// the outermost Scope on the thread ends and keeps its blocks, so calls in steady state take such buffers
+// without going to the general heap
+class Arena : public std::pmr::memory_resource {
+public:
+	class Scope {
+	public:
+		Scope ();
+		~Scope ();
+		Scope ( const Scope& ) = delete;
+		Scope& operator= ( const Scope& ) = delete;
+	};
+
+	static Arena& Local ();
+	// Allocations on all threads served from blocks the arena already held
+	static uint64_t Avoided ();
+private:
+	// The first block, and the most a thread keeps between calls, larger rounds give memory back
+	static constexpr size_t Block { 64 << 10 };
+	static constexpr size_t Limit { 16 << 20 };
+
+	struct Chunk {
+		std::unique_ptr<std::byte[]> Data;
+		size_t Size;
+	};
+
+	std::vector<Chunk> Chunks;
+	size_t Current { 0 };
+	size_t Used { 0 };
+	size_t Depth { 0 };
+
+	void* do_allocate ( size_t Bytes, size_t Alignment ) override;
+	void do_deallocate ( void* Pointer, size_t Bytes, size_t Alignment ) override;
+	[[nodiscard]] bool do_is_equal ( const std::pmr::memory_resource& Other ) const noexcept override;
+	void* take ( size_t Bytes, size_t Alignment );
+	void rewind ();
+};
+#endif
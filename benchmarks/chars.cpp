@@ -0,0 +1,84 @@
+#include "../chars.h"
+#include <benchmark/benchmark.h>
+#include <memory_resource>
+#include <string>
+
+namespace {
+	std::wstring wide ( size_t Size ) {
+		std::wstring result;
+		result.reserve ( Size + 64 );
+		while ( result.size () < Size ) {
+			result.append ( L"Ошибка при вызове метода контекста (Выполнить): строка 42. " );
+		}
+		return result;
+	}
+
+	std::basic_string<WCHAR_T> units ( size_t Size ) {
+		auto source = wide ( Size );
+		return { source.begin (), source.end () };
+	}
+}
+
+// A 1C argument read as wchar_t, a copy into the kept buffer on Linux
+static void charsWiden ( benchmark::State& State ) {
+	auto source = units ( State.range ( 0 ) );
+	std::wstring buffer;
+	for ( auto _ : State ) {
+		auto result = Chars::Widen ( source, buffer );
+		benchmark::DoNotOptimize ( result.data () );
+	}
+	State.SetBytesProcessed ( State.iterations () * source.size () * sizeof ( WCHAR_T ) );
+}
+BENCHMARK ( charsWiden )->Arg ( 64 )->Arg ( 1 << 20 );
+
+static void charsWCHARToWide ( benchmark::State& State ) {
+	auto source = units ( State.range ( 0 ) );
+	for ( auto _ : State ) {
+		auto result = Chars::WCHARToWide ( source.c_str (), source.size () );
+		benchmark::DoNotOptimize ( result.data () );
+	}
+	State.SetBytesProcessed ( State.iterations () * source.size () * sizeof ( WCHAR_T ) );
+}
+BENCHMARK ( charsWCHARToWide )->Arg ( 64 )->Arg ( 1 << 20 );
+
+// A result string on its way to 1C, into an arena as the components return them
+static void charsToWCHAR ( benchmark::State& State ) {
+	auto source = wide ( State.range ( 0 ) );
+	std::pmr::monotonic_buffer_resource arena;
+	for ( auto _ : State ) {
+		auto result = Chars::ToWCHAR ( source, &arena );
+		benchmark::DoNotOptimize ( result.data () );
+		arena.release ();
+	}
+	State.SetBytesProcessed ( State.iterations () * source.size () * sizeof ( wchar_t ) );
+}
+BENCHMARK ( charsToWCHAR )->Arg ( 64 )->Arg ( 1 << 20 );
+
+static void charsStringToWide ( benchmark::State& State ) {
+	auto source = Chars::WideToString ( wide ( State.range ( 0 ) ) );
+	for ( auto _ : State ) {
+		auto result = Chars::StringToWide ( source );
+		benchmark::DoNotOptimize ( result.data () );
+	}
+	State.SetBytesProcessed ( State.iterations () * source.size () );
+}
+BENCHMARK ( charsStringToWide )->Arg ( 64 )->Arg ( 1 << 20 );
+
+static void charsWideToString ( benchmark::State& State ) {
+	auto source = wide ( State.range ( 0 ) );
+	for ( auto _ : State ) {
+		auto result = Chars::WideToString ( source );
+		benchmark::DoNotOptimize ( result.data () );
+	}
+	State.SetBytesProcessed ( State.iterations () * source.size () * sizeof ( wchar_t ) );
+}
+BENCHMARK ( charsWideToString )->Arg ( 64 )->Arg ( 1 << 20 );
+
+static void charsLength ( benchmark::State& State ) {
+	auto source = units ( State.range ( 0 ) );
+	for ( auto _ : State ) {
+		benchmark::DoNotOptimize ( Chars::WCHARLength ( source.c_str () ) );
+	}
+	State.SetBytesProcessed ( State.iterations () * source.size () * sizeof ( WCHAR_T ) );
+}
+BENCHMARK ( charsLength )->Arg ( 64 )->Arg ( 1 << 20 );
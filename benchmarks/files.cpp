@@ -0,0 +1,23 @@
+#include "../files.h"
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+// Hash of the trimmed text of a file, read whole
+static void filesToHash ( benchmark::State& State ) {
+	auto path = std::filesystem::temp_directory_path () / "benchmark.hash";
+	{
+		std::ofstream file ( path, std::ios::binary );
+		std::string line { "Процедура ПриОткрытии ( Отказ ) Экспорт // строка модуля формы\n" };
+		for ( int64_t size = 0; size < State.range ( 0 ); size += line.size () ) {
+			file << line;
+		}
+	}
+	for ( auto _ : State ) {
+		benchmark::DoNotOptimize ( files::toHash ( path.string () ) );
+	}
+	State.SetBytesProcessed ( State.iterations () * std::filesystem::file_size ( path ) );
+	std::filesystem::remove ( path );
+}
+BENCHMARK ( filesToHash )->Arg ( 4 << 10 )->Arg ( 4 << 20 );
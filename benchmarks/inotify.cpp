@@ -0,0 +1,84 @@
+#ifdef __linux__
+#include "../inotify.h"
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+namespace Inotify {
+	struct Benchmark {
+		// Fills the buffer as read from the descriptor would: Count events on files of Folder, the names
+		// padded to 16 bytes as the kernel does
+		static int fill ( Inotify& Watcher, int Count ) {
+			size_t size { 0 };
+			for ( int i = 0; i < Count; ++i ) {
+				auto name = "file" + std::to_string ( i % 64 ) + ".txt";
+				auto length = ( name.size () / 16 + 1 ) * 16;
+				if ( size + EventSize + length > Watcher.EventBuffer.size () ) {
+					break;
+				}
+				auto event = reinterpret_cast<inotify_event*> ( Watcher.EventBuffer.data () + size );
+				event->wd = 1;
+				event->mask = i % 2 ? IN_MODIFY : IN_CREATE;
+				event->cookie = 0;
+				event->len = static_cast<uint32_t> ( length );
+				std::memset ( event->name, 0, length );
+				std::memcpy ( event->name, name.data (), name.size () );
+				size += EventSize + length;
+			}
+			return static_cast<int> ( size );
+		}
+
+		static void fetch ( Inotify& Watcher, int Size, std::vector<SystemEvent>& Events ) {
+			Watcher.fetchEvents ( Size, Events );
+		}
+
+		static void watch ( Inotify& Watcher, const std::filesystem::path& Folder ) {
+			Watcher.Folders.emplace ( 1, Folder );
+			Watcher.Subscribe ( { Action::create, Action::modify }, [] ( const Notification& ) {} );
+		}
+	};
+}
+
+// Parsing of one read from the inotify descriptor into events with full paths
+static void inotifyFetchEvents ( benchmark::State& State ) {
+	auto folder = std::filesystem::temp_directory_path () / "benchmark.inotify";
+	std::filesystem::create_directories ( folder );
+	for ( int i = 0; i < 64; ++i ) {
+		std::ofstream ( folder / ( "file" + std::to_string ( i ) + ".txt" ) ) << i;
+	}
+	Inotify::Inotify watcher;
+	Inotify::Benchmark::watch ( watcher, folder );
+	auto size = Inotify::Benchmark::fill ( watcher, State.range ( 0 ) );
+	std::vector<Inotify::SystemEvent> events;
+	for ( auto _ : State ) {
+		events.clear ();
+		Inotify::Benchmark::fetch ( watcher, size, events );
+		benchmark::DoNotOptimize ( events.data () );
+	}
+	State.SetItemsProcessed ( State.iterations () * events.size () );
+	std::filesystem::remove_all ( folder );
+}
+BENCHMARK ( inotifyFetchEvents )->Arg ( 16 )->Arg ( 1024 );
+
+// Start on a tree of 64 folders with the given number of folders in each, and a few files in every one
+static void inotifyWatch ( benchmark::State& State ) {
+	auto root = std::filesystem::temp_directory_path () / "benchmark.tree";
+	for ( int i = 0; i < 64; ++i ) {
+		for ( int j = 0; j < State.range ( 0 ); ++j ) {
+			auto folder = root / std::to_string ( i ) / std::to_string ( j );
+			std::filesystem::create_directories ( folder );
+			for ( int k = 0; k < 4; ++k ) {
+				std::ofstream ( folder / ( "file" + std::to_string ( k ) + ".txt" ) ) << k;
+			}
+		}
+	}
+	for ( auto _ : State ) {
+		Inotify::Inotify watcher;
+		watcher.Watch ( root );
+	}
+	State.SetItemsProcessed ( State.iterations () * 64 * ( State.range ( 0 ) + 1 ) );
+	std::filesystem::remove_all ( root );
+}
+BENCHMARK ( inotifyWatch )->Arg ( 16 )->Arg ( 256 )->Unit ( benchmark::kMillisecond );
+#endif
@@ -0,0 +1,162 @@
+#include "../json.h"
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+
+namespace {
+	std::vector<std::wstring> sample ( size_t Count ) {
+		std::vector<std::wstring> result;
+		result.reserve ( Count );
+		for ( size_t i = 0; i < Count; ++i ) {
+			result.push_back ( L"Запись \"" + std::to_wstring ( i ) + L"\" в журнале\tрегистрации" );
+		}
+		return result;
+	}
+}
+
+// Builds the Regex.Select shaped result through the DOM
+static void jsonDom ( benchmark::State& State ) {
+	auto values = sample ( State.range ( 0 ) );
+	for ( auto _ : State ) {
+		JSON::Array json;
+		for ( auto& value : values ) {
+			auto record = json.Add<JSON::Object> ();
+			record->Add<JSON::String> ( L"Value" )->Set ( value );
+			auto groups = record->Add<JSON::Array> ( L"Groups" );
+			groups->Add<JSON::String> ()->Set ( value );
+		}
+		std::wstring result;
+		json.Presentation ( &result );
+		benchmark::DoNotOptimize ( result.data () );
+	}
+	State.SetItemsProcessed ( State.iterations () * values.size () );
+}
+BENCHMARK ( jsonDom )->Arg ( 1000 )->Arg ( 100000 );
+
+// The same result through the streaming writer, in every output encoding
+template <typename Char>
+static void jsonWriter ( benchmark::State& State ) {
+	auto values = sample ( State.range ( 0 ) );
+	for ( auto _ : State ) {
+		JSON::Writer<Char> json;
+		json.BeginArray ();
+		for ( auto& value : values ) {
+			json.BeginObject ().Key ( L"Value" ).String ( value );
+			json.Key ( L"Groups" ).BeginArray ().String ( value ).EndArray ().EndObject ();
+		}
+		json.EndArray ();
+		benchmark::DoNotOptimize ( json.Text ().data () );
+	}
+	State.SetItemsProcessed ( State.iterations () * values.size () );
+}
+BENCHMARK_TEMPLATE ( jsonWriter, wchar_t )->Arg ( 1000 )->Arg ( 100000 );
+BENCHMARK_TEMPLATE ( jsonWriter, char16_t )->Arg ( 1000 )->Arg ( 100000 );
+BENCHMARK_TEMPLATE ( jsonWriter, char )->Arg ( 1000 )->Arg ( 100000 );
+
+// The same result as a CBOR or MessagePack blob
+static void jsonBinary ( benchmark::State& State ) {
+	auto values = sample ( State.range ( 0 ) );
+	auto format = State.range ( 1 ) ? JSON::Encoding::CBOR : JSON::Encoding::MessagePack;
+	for ( auto _ : State ) {
+		JSON::Binary json ( format );
+		json.BeginArray ();
+		for ( auto& value : values ) {
+			json.BeginObject ().Key ( L"Value" ).String ( value );
+			json.Key ( L"Groups" ).BeginArray ().String ( value ).EndArray ().EndObject ();
+		}
+		json.EndArray ();
+		benchmark::DoNotOptimize ( json.Data ().data () );
+	}
+	State.SetItemsProcessed ( State.iterations () * values.size () );
+}
+BENCHMARK ( jsonBinary )->Args ( { 1000, 1 } )->Args ( { 100000, 1 } )->Args ( { 1000, 0 } )->Args ( { 100000, 0 } );
+
+namespace {
+	std::wstring text ( size_t Size, bool Escapes = true ) {
+		std::wstring result;
+		result.reserve ( Size );
+		while ( result.size () < Size ) {
+			result.append ( Escapes ? L"Ошибка при вызове метода контекста (Выполнить): строка 42, \"Справочник\"\n"
+									: L"Ошибка при вызове метода контекста (Выполнить): строка 42, Справочник. " );
+		}
+		result.resize ( Size );
+		return result;
+	}
+}
+
+// Escaping of long mostly clean text, compared with a plain copy of the same text
+static void jsonEscape ( benchmark::State& State ) {
+	auto source = text ( State.range ( 0 ) );
+	std::wstring result;
+	for ( auto _ : State ) {
+		result.clear ();
+		JSON::escape ( &result, source );
+		benchmark::DoNotOptimize ( result.data () );
+	}
+	State.SetBytesProcessed ( State.iterations () * source.size () * sizeof ( wchar_t ) );
+}
+BENCHMARK ( jsonEscape )->Arg ( 1 << 16 )->Arg ( 1 << 22 );
+
+static void jsonEscapePlain ( benchmark::State& State ) {
+	auto source = text ( State.range ( 0 ), false );
+	std::wstring result;
+	for ( auto _ : State ) {
+		result.clear ();
+		JSON::escape ( &result, source );
+		benchmark::DoNotOptimize ( result.data () );
+	}
+	State.SetBytesProcessed ( State.iterations () * source.size () * sizeof ( wchar_t ) );
+}
+BENCHMARK ( jsonEscapePlain )->Arg ( 1 << 16 )->Arg ( 1 << 22 );
+
+static void jsonCopy ( benchmark::State& State ) {
+	auto source = text ( State.range ( 0 ) );
+	std::wstring result;
+	for ( auto _ : State ) {
+		result.clear ();
+		result.append ( source );
+		benchmark::DoNotOptimize ( result.data () );
+	}
+	State.SetBytesProcessed ( State.iterations () * source.size () * sizeof ( wchar_t ) );
+}
+BENCHMARK ( jsonCopy )->Arg ( 1 << 16 )->Arg ( 1 << 22 );
+
+namespace {
+	std::wstring document ( size_t Count ) {
+		JSON::Writer<wchar_t> json;
+		json.BeginArray ();
+		for ( size_t i = 0; i < Count; ++i ) {
+			json.BeginObject ().Key ( L"Ссылка" ).String ( L"e1cib/data/Справочник.Номенклатура?ref=" + std::to_wstring ( i ) );
+			json.Key ( L"Количество" ).Number ( static_cast<int64_t> ( i ) ).Key ( L"Цена" ).Number ( i * 1.25 );
+			json.Key ( L"Описание" ).String ( text ( 200 ) ).Key ( L"Удален" ).Bool ( false ).EndObject ();
+		}
+		json.EndArray ();
+		return std::wstring ( json.View () );
+	}
+}
+
+// Tokenizing a whole document, and skipping it as Extract does with values no path can reach
+static void jsonReader ( benchmark::State& State ) {
+	auto source = document ( State.range ( 0 ) );
+	for ( auto _ : State ) {
+		JSON::Reader<wchar_t> json ( source );
+		size_t count { 0 };
+		for ( auto token = json.Next (); token != JSON::Token::End && token != JSON::Token::Error; token = json.Next () ) {
+			++count;
+		}
+		benchmark::DoNotOptimize ( count );
+	}
+	State.SetBytesProcessed ( State.iterations () * source.size () * sizeof ( wchar_t ) );
+}
+BENCHMARK ( jsonReader )->Arg ( 1000 )->Arg ( 20000 );
+
+static void jsonReaderSkip ( benchmark::State& State ) {
+	auto source = document ( State.range ( 0 ) );
+	for ( auto _ : State ) {
+		JSON::Reader<wchar_t> json ( source );
+		json.Next ();
+		benchmark::DoNotOptimize ( json.Skip () );
+	}
+	State.SetBytesProcessed ( State.iterations () * source.size () * sizeof ( wchar_t ) );
+}
+BENCHMARK ( jsonReaderSkip )->Arg ( 1000 )->Arg ( 20000 );
@@ -0,0 +1,157 @@
+#include "../chars.h"
+#include "../json.h"
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+// Besides the usual benchmark flags:
+//   --baseline_out=FILE  saves the time per iteration of every benchmark run as a JSON baseline
+//   --baseline=FILE      compares the run with a saved baseline, the exit code is 1 when any benchmark
+//                        got slower than the baseline by more than the tolerance
+//   --tolerance=0.15     the allowed slowdown, a fraction of the baseline time
+namespace {
+	using Times = std::map<std::string, double>;
+
+	// Keeps the fastest iteration time of every benchmark, in nanoseconds, repetitions included
+	class Collector : public benchmark::ConsoleReporter {
+	public:
+		Times Results;
+
+		void ReportRuns ( const std::vector<Run>& Reports ) override {
+			ConsoleReporter::ReportRuns ( Reports );
+			for ( auto& run : Reports ) {
+				if ( run.run_type != Run::RT_Iteration || run.iterations == 0 ) {
+					continue;
+				}
+				auto time = run.real_accumulated_time * 1e9 / static_cast<double> ( run.iterations );
+				auto [ position, added ] = Results.emplace ( run.benchmark_name (), time );
+				if ( !added && time < position->second ) {
+					position->second = time;
+				}
+			}
+		}
+	};
+
+	bool option ( const char* Argument, const char* Name, std::string& Value ) {
+		auto size = std::strlen ( Name );
+		if ( std::strncmp ( Argument, Name, size ) != 0 || Argument[ size ] != '=' ) {
+			return false;
+		}
+		Value = Argument + size + 1;
+		return true;
+	}
+
+	bool save ( const std::string& Path, const Times& Results ) {
+		JSON::Writer<char> json;
+		json.BeginObject ().Key ( L"Unit" ).String ( L"ns" ).Key ( L"Benchmarks" ).BeginObject ();
+		for ( auto& [ name, time ] : Results ) {
+			json.Key ( Chars::StringToWide ( name ) ).Number ( time );
+		}
+		json.EndObject ().EndObject ();
+		std::ofstream file ( Path, std::ios::binary );
+		file << json.View () << '\n';
+		return static_cast<bool> ( file );
+	}
+
+	bool load ( const std::string& Path, Times& Baseline ) {
+		std::ifstream file ( Path, std::ios::binary );
+		if ( !file ) {
+			return false;
+		}
+		std::string text ( std::istreambuf_iterator<char> ( file ), {} );
+		JSON::Reader<char> json ( text );
+		std::wstring key;
+		int depth { 0 };
+		bool inside { false };
+		for ( auto token = json.Next (); token != JSON::Token::End; token = json.Next () ) {
+			switch ( token ) {
+				case JSON::Token::Error:
+					return false;
+				case JSON::Token::BeginObject:
+				case JSON::Token::BeginArray:
+					++depth;
+					break;
+				case JSON::Token::EndObject:
+				case JSON::Token::EndArray:
+					--depth;
+					inside = inside && depth > 1;
+					break;
+				case JSON::Token::Key:
+					key.clear ();
+					if ( !JSON::unescape ( json.Value (), key ) ) {
+						return false;
+					}
+					if ( depth == 1 && key == L"Benchmarks" ) {
+						inside = true;
+					}
+					break;
+				case JSON::Token::Number:
+					if ( inside && depth == 2 ) {
+						Baseline[ Chars::WideToString ( key ) ] = std::strtod ( std::string ( json.Value () ).c_str (), nullptr );
+					}
+					break;
+				default:
+					break;
+			}
+		}
+		return true;
+	}
+
+	// Prints every benchmark of the run next to its baseline, true when none is slower than Tolerance allows
+	bool compare ( const Times& Baseline, const Times& Results, double Tolerance ) {
+		auto passed = true;
+		std::printf ( "\n%-60s %14s %14s %9s\n", "Benchmark", "Baseline, ns", "Now, ns", "Change" );
+		for ( auto& [ name, time ] : Results ) {
+			auto base = Baseline.find ( name );
+			if ( base == Baseline.end () || base->second <= 0 ) {
+				std::printf ( "%-60s %14s %14.1f %9s\n", name.c_str (), "-", time, "new" );
+				continue;
+			}
+			auto change = time / base->second - 1;
+			auto regressed = change > Tolerance;
+			passed = passed && !regressed;
+			std::printf ( "%-60s %14.1f %14.1f %+8.1f%%%s\n", name.c_str (), base->second, time, change * 100,
+						  regressed ? "  REGRESSION" : "" );
+		}
+		return passed;
+	}
+}
+
+int main ( int argc, char** argv ) {
+	std::string baseline, output, tolerance { "0.15" };
+	std::vector<char*> arguments;
+	for ( int i = 0; i < argc; ++i ) {
+		if ( !option ( argv[ i ], "--baseline", baseline ) && !option ( argv[ i ], "--baseline_out", output )
+			 && !option ( argv[ i ], "--tolerance", tolerance ) ) {
+			arguments.push_back ( argv[ i ] );
+		}
+	}
+	auto count = static_cast<int> ( arguments.size () );
+	benchmark::Initialize ( &count, arguments.data () );
+	if ( benchmark::ReportUnrecognizedArguments ( count, arguments.data () ) ) {
+		return 2;
+	}
+	Times before;
+	if ( !baseline.empty () && !load ( baseline, before ) ) {
+		std::cerr << "Can't read the baseline " << baseline << '\n';
+		return 2;
+	}
+	Collector collector;
+	benchmark::RunSpecifiedBenchmarks ( &collector );
+	benchmark::Shutdown ();
+	if ( !output.empty () && !save ( output, collector.Results ) ) {
+		std::cerr << "Can't write the baseline " << output << '\n';
+		return 2;
+	}
+	if ( !baseline.empty () && !compare ( before, collector.Results, std::strtod ( tolerance.c_str (), nullptr ) ) ) {
+		return 1;
+	}
+	return 0;
+}
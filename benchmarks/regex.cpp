@@ -0,0 +1,100 @@
+#ifdef __linux__
+#include "../host/host.h"
+#include "../regex.h"
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+
+namespace {
+	using host::Text;
+
+	Text units ( std::wstring_view Source ) {
+		return { Source.begin (), Source.end () };
+	}
+
+	Text journal ( size_t Count ) {
+		std::wstring result;
+		for ( size_t i = 0; i < Count; ++i ) {
+			result += L"2024-03-" + std::to_wstring ( 10 + i % 20 ) + L" Запись " + std::to_wstring ( i )
+					  + L": ошибка при вызове метода контекста (Выполнить)\n";
+		}
+		return units ( result );
+	}
+
+	tVariant string ( const Text& Value ) {
+		tVariant result {};
+		result.vt = VTYPE_PWSTR;
+		result.pwstrVal = const_cast<WCHAR_T*> ( Value.data () );
+		result.wstrLen = static_cast<uint32_t> ( Value.size () );
+		return result;
+	}
+
+	// The component as 1C calls it: a method found by name, tVariant arguments, the result freed by the caller
+	class Component {
+	public:
+		explicit Component ( std::wstring_view Method ) {
+			Object.setMemManager ( &Memory );
+			Object.Extender::Init ( &Host );
+			auto name = units ( Method );
+			Index = Object.FindMethod ( name.c_str () );
+			Params.resize ( Object.GetNParams ( Index ) );
+			for ( size_t i = 0; i < Params.size (); ++i ) {
+				Params[ i ].vt = VTYPE_EMPTY;
+			}
+		}
+
+		~Component () {
+			Object.Done ();
+		}
+
+		void Set ( size_t Index, const Text& Value ) {
+			Params[ Index ] = string ( Value );
+		}
+
+		bool Call () {
+			tVariant result {};
+			auto success = Object.CallAsFunc ( Index, &result, Params.data (), static_cast<long> ( Params.size () ) );
+			if ( result.vt == VTYPE_PWSTR ) {
+				Memory.FreeMemory ( reinterpret_cast<void**> ( &result.pwstrVal ) );
+			} else if ( result.vt == VTYPE_BLOB ) {
+				Memory.FreeMemory ( reinterpret_cast<void**> ( &result.pstrVal ) );
+			}
+			return success;
+		}
+	private:
+		host::Memory Memory;
+		host::Connection Host;
+		Regex Object;
+		long Index;
+		std::vector<tVariant> Params;
+	};
+}
+
+// Regex.Test over a journal that has no match, so the whole text is searched
+static void regexTest ( benchmark::State& State ) {
+	auto text = journal ( State.range ( 0 ) );
+	auto pattern = units ( L"Запись \\d+: успешно" );
+	Component regex ( L"Test" );
+	regex.Set ( 0, text );
+	regex.Set ( 1, pattern );
+	for ( auto _ : State ) {
+		benchmark::DoNotOptimize ( regex.Call () );
+	}
+	State.SetBytesProcessed ( State.iterations () * text.size () * sizeof ( WCHAR_T ) );
+}
+BENCHMARK ( regexTest )->Arg ( 10 )->Arg ( 10000 );
+
+// Regex.Select of every record with its groups, as a JSON result
+static void regexSelect ( benchmark::State& State ) {
+	auto text = journal ( State.range ( 0 ) );
+	auto pattern = units ( L"(\\d{4})-(\\d{2})-(\\d{2}) Запись (\\d+)" );
+	Component regex ( L"Select" );
+	regex.Set ( 0, text );
+	regex.Set ( 1, pattern );
+	for ( auto _ : State ) {
+		benchmark::DoNotOptimize ( regex.Call () );
+	}
+	State.SetItemsProcessed ( State.iterations () * State.range ( 0 ) );
+}
+BENCHMARK ( regexSelect )->Arg ( 10 )->Arg ( 10000 );
+#endif
@@ -0,0 +1,46 @@
+#ifdef __linux__
+#include "../shooter.h"
+#include <benchmark/benchmark.h>
+#include <vector>
+
+struct ShooterBenchmark {
+	// A 32 bit ZPixmap as XGetImage returns it, with a gradient so the encoder has something to compress
+	static XImage image ( int Width, int Height, std::vector<char>& Pixels ) {
+		Pixels.resize ( static_cast<size_t> ( Width ) * Height * 4 );
+		for ( size_t i = 0; i < Pixels.size (); i += 4 ) {
+			auto pixel = i / 4;
+			Pixels[ i ] = static_cast<char> ( pixel % Width );
+			Pixels[ i + 1 ] = static_cast<char> ( pixel / Width );
+			Pixels[ i + 2 ] = static_cast<char> ( pixel * 7 );
+			Pixels[ i + 3 ] = static_cast<char> ( 255 );
+		}
+		XImage result {};
+		result.width = Width;
+		result.height = Height;
+		result.format = ZPixmap;
+		result.data = Pixels.data ();
+		result.byte_order = LSBFirst;
+		result.bitmap_unit = 32;
+		result.bitmap_pad = 32;
+		result.depth = 24;
+		result.bytes_per_line = Width * 4;
+		result.bits_per_pixel = 32;
+		return result;
+	}
+
+	static size_t encode ( XImage& Image ) {
+		return Shooter::getPng { &Image } ().Size;
+	}
+};
+
+// Shooter.Take after the window is captured, a screen sized image to PNG
+static void shooterPng ( benchmark::State& State ) {
+	std::vector<char> pixels;
+	auto image = ShooterBenchmark::image ( State.range ( 0 ), State.range ( 1 ), pixels );
+	for ( auto _ : State ) {
+		benchmark::DoNotOptimize ( ShooterBenchmark::encode ( image ) );
+	}
+	State.SetBytesProcessed ( State.iterations () * pixels.size () );
+}
+BENCHMARK ( shooterPng )->Args ( { 320, 240 } )->Args ( { 1920, 1080 } )->Unit ( benchmark::kMillisecond );
+#endif
@@ -0,0 +1,86 @@
+#include "../unicode.h"
+#include <benchmark/benchmark.h>
+#include <codecvt>
+#include <locale>
+#include <string>
+
+namespace {
+	std::string utf8 ( size_t Size, bool Cyrillic ) {
+		std::string result;
+		result.reserve ( Size + 128 );
+		while ( result.size () < Size ) {
+			result.append ( Cyrillic ? u8"Ошибка при вызове метода контекста (Выполнить): строка 42. "
+									 : u8"Error calling context method (Execute): line 42, Catalog. " );
+		}
+		return result;
+	}
+}
+
+// UTF-8 to UTF-16 wchar_t, the StringToWide path, against the codecvt converter it replaces
+static void unicodeToWide ( benchmark::State& State ) {
+	auto source = utf8 ( 1 << 20, State.range ( 0 ) );
+	std::wstring result;
+	for ( auto _ : State ) {
+		result.clear ();
+		unicode::utf8To16 ( source, result );
+		benchmark::DoNotOptimize ( result.data () );
+	}
+	State.SetBytesProcessed ( State.iterations () * source.size () );
+}
+BENCHMARK ( unicodeToWide )->Arg ( 0 )->Arg ( 1 );
+
+static void codecvtToWide ( benchmark::State& State ) {
+	auto source = utf8 ( 1 << 20, State.range ( 0 ) );
+	std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+	for ( auto _ : State ) {
+		auto result = converter.from_bytes ( source );
+		benchmark::DoNotOptimize ( result.data () );
+	}
+	State.SetBytesProcessed ( State.iterations () * source.size () );
+}
+BENCHMARK ( codecvtToWide )->Arg ( 0 )->Arg ( 1 );
+
+static void unicodeToUtf16 ( benchmark::State& State ) {
+	auto source = utf8 ( 1 << 20, State.range ( 0 ) );
+	std::u16string result;
+	for ( auto _ : State ) {
+		result.clear ();
+		unicode::utf8To16 ( source, result );
+		benchmark::DoNotOptimize ( result.data () );
+	}
+	State.SetBytesProcessed ( State.iterations () * source.size () );
+}
+BENCHMARK ( unicodeToUtf16 )->Arg ( 0 )->Arg ( 1 );
+
+// UTF-16 wchar_t back to UTF-8, the WideToString path
+static void unicodeToString ( benchmark::State& State ) {
+	auto source = unicode::utf8To16<wchar_t> ( utf8 ( 1 << 20, State.range ( 0 ) ) );
+	std::string result;
+	for ( auto _ : State ) {
+		result.clear ();
+		unicode::utf16To8<wchar_t> ( source, result );
+		benchmark::DoNotOptimize ( result.data () );
+	}
+	State.SetBytesProcessed ( State.iterations () * source.size () * sizeof ( wchar_t ) );
+}
+BENCHMARK ( unicodeToString )->Arg ( 0 )->Arg ( 1 );
+
+static void codecvtToString ( benchmark::State& State ) {
+	auto source = unicode::utf8To16<wchar_t> ( utf8 ( 1 << 20, State.range ( 0 ) ) );
+	std::wstring_convert<std::codecvt_utf8<wchar_t>, wchar_t> converter;
+	for ( auto _ : State ) {
+		auto result = converter.to_bytes ( source );
+		benchmark::DoNotOptimize ( result.data () );
+	}
+	State.SetBytesProcessed ( State.iterations () * source.size () * sizeof ( wchar_t ) );
+}
+BENCHMARK ( codecvtToString )->Arg ( 0 )->Arg ( 1 );
+
+static void unicodeFix ( benchmark::State& State ) {
+	auto source = utf8 ( 1 << 20, State.range ( 0 ) );
+	for ( auto _ : State ) {
+		benchmark::DoNotOptimize ( unicode::fix ( source ).data () );
+	}
+	State.SetBytesProcessed ( State.iterations () * source.size () );
+}
+BENCHMARK ( unicodeFix )->Arg ( 0 )->Arg ( 1 );
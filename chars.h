@@ -1,12 +1,85 @@
 #ifndef __chars_h__
 #define __chars_h__
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include "1c/types.h"
+#include <iterator>
 #include <string>
+#include <string_view>
 #include <memory>
+#include <memory_resource>
 
 class Chars {
 public:
+	// 1C strings as they come in tVariant: UTF-16 units, which are not wchar_t on Linux.
+	// Code that only reads an argument works on the view in place instead of copying it into std::wstring
+	using View = std::basic_string_view<WCHAR_T>;
+
+#ifdef __linux__
+	// Reads a View as wchar_t, so std::regex and other wchar_t algorithms run over the argument without a copy
+	class Units {
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = wchar_t;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const wchar_t*;
+		using reference = wchar_t;
+
+		Units () = default;
+		explicit Units ( const WCHAR_T* Position ) : Current ( Position ) {}
+		wchar_t operator* () const { return *Current; }
+		wchar_t operator[] ( difference_type Offset ) const { return Current[ Offset ]; }
+		Units& operator++ () { ++Current; return *this; }
+		Units operator++ ( int ) { auto copy = *this; ++Current; return copy; }
+		Units& operator-- () { --Current; return *this; }
+		Units operator-- ( int ) { auto copy = *this; --Current; return copy; }
+		Units& operator+= ( difference_type Offset ) { Current += Offset; return *this; }
+		Units& operator-= ( difference_type Offset ) { Current -= Offset; return *this; }
+		friend Units operator+ ( Units Left, difference_type Offset ) { return Left += Offset; }
+		friend Units operator+ ( difference_type Offset, Units Right ) { return Right += Offset; }
+		friend Units operator- ( Units Left, difference_type Offset ) { return Left -= Offset; }
+		friend difference_type operator- ( Units Left, Units Right ) { return Left.Current - Right.Current; }
+		friend bool operator== ( Units Left, Units Right ) { return Left.Current == Right.Current; }
+		friend bool operator!= ( Units Left, Units Right ) { return Left.Current != Right.Current; }
+		friend bool operator< ( Units Left, Units Right ) { return Left.Current < Right.Current; }
+		friend bool operator> ( Units Left, Units Right ) { return Left.Current > Right.Current; }
+		friend bool operator<= ( Units Left, Units Right ) { return Left.Current <= Right.Current; }
+		friend bool operator>= ( Units Left, Units Right ) { return Left.Current >= Right.Current; }
+	private:
+		const WCHAR_T* Current { nullptr };
+	};
+#elif _WIN32
+	using Units = const wchar_t*;
+#endif
+
+	static View ToView ( const WCHAR_T* Source, size_t Length = 0 ) {
+		if ( Source == nullptr ) {
+			return {};
+		}
+		return { Source, Length ? Length : WCHARLength ( Source ) };
+	}
+
+	static View ToView ( const tVariant* Source ) {
+		if ( Source->vt != VTYPE_PWSTR || Source->pwstrVal == nullptr ) {
+			return {};
+		}
+		return { Source->pwstrVal, Source->wstrLen };
+	}
+
+	static Units Begin ( View Source ) {
+		return Units ( Source.data () );
+	}
+
+	static Units End ( View Source ) {
+		return Units ( Source.data () + Source.size () );
+	}
+
+	static bool Same ( View Left, std::wstring_view Right ) {
+		return std::equal ( Left.begin (), Left.end (), Right.begin (), Right.end (),
+							[] ( auto a, auto b ) { return static_cast<uint32_t> ( a ) == static_cast<uint32_t> ( b ); } );
+	}
+
 	template <typename SourceType>
 	static uint32_t ToWCHAR ( WCHAR_T** Destination, const SourceType* Source ) {
 		size_t size;
@@ -44,10 +117,17 @@ public:
 		return result;
 	}
 
-	static std::unique_ptr<wchar_t[]> FromWCHAR ( const WCHAR_T* Source, size_t Length = 0 );
-	static std::wstring StringToWide ( const std::string& Source );
-	static std::string WideToString ( const std::wstring& Source );
+	// Source as a NUL-terminated 1C string, in a buffer from Memory
+	static std::pmr::basic_string<WCHAR_T> ToWCHAR ( std::wstring_view Source, std::pmr::memory_resource* Memory ) {
+		return { Source.begin (), Source.end (), Memory };
+	}
+
+	static std::wstring StringToWide ( std::string_view Source );
+	static std::string WideToString ( std::wstring_view Source );
 	static std::wstring WCHARToWide ( const WCHAR_T* String, size_t Length = 0 );
+	// Source as wchar_t: the view itself where WCHAR_T is wchar_t, else a copy in Buffer, which callers keep
+	// between calls so its capacity is reused
+	static std::wstring_view Widen ( View Source, std::wstring& Buffer );
 	static uint32_t WCHARLength ( const WCHAR_T* Source );
 };
 #endif
\ No newline at end of file
@@ -1,7 +1,7 @@
 #include "corestrings.h"
+#include "unicode.h"
 #include <algorithm>
 #include <cstdint>
-#include <utf8.h>
 #include <xxhash.h>
 
 namespace strings {
@@ -90,10 +90,7 @@ bool isValidXML ( char c ) {
 }
 
 std::string fix ( const std::string& str ) {
-	std::string result;
-	result.reserve ( str.size () );
-	utf8::replace_invalid ( str.begin (), str.end (), back_inserter ( result ) );
-	return result;
+	return unicode::fix ( str );
 }
 
 std::string clean ( const std::string& input ) {
@@ -0,0 +1,167 @@
+#include "debounce.h"
+#include <algorithm>
+#include <utility>
+#include "trace.h"
+
+Debouncer::Debouncer ( Send Target ) : Target ( std::move ( Target ) ), Wheel ( Slots ), Origin ( Clock::now () ) {}
+
+Debouncer::~Debouncer () {
+	Stop ();
+}
+
+void Debouncer::Add ( Chars::View Path, Change Event, bool Folder, long Window ) {
+	auto ticks = std::clamp<long> ( ( Window + Tick.count () - 1 ) / Tick.count (), 1, Slots - 1 );
+	std::lock_guard<std::mutex> guard ( Lock );
+	if ( Closed ) {
+		return;
+	}
+	auto idle = Pending.empty ();
+	if ( idle ) {
+		Done = now ();
+	}
+	auto slot = static_cast<size_t> ( ( now () + ticks ) % Slots );
+	auto [ position, added ] = Pending.try_emplace ( Text ( Path ), Entry { Event, Folder, slot, {} } );
+	auto& entry = position->second;
+	if ( added ) {
+		entry.Position = Wheel[ slot ].insert ( Wheel[ slot ].end (), &position->first );
+	} else if ( !merge ( entry.Net, Event ) ) {
+		Wheel[ entry.Slot ].erase ( entry.Position );
+		Pending.erase ( position );
+		return;
+	} else {
+		entry.Folder = Folder;
+		Wheel[ slot ].splice ( Wheel[ slot ].end (), Wheel[ entry.Slot ], entry.Position );
+		entry.Slot = slot;
+	}
+	if ( !Worker.joinable () && !Joining ) {
+		start ();
+	}
+	if ( idle ) {
+		Ready.notify_one ();
+	}
+}
+
+void Debouncer::Flush ( Chars::View Path ) {
+	std::lock_guard<std::mutex> guard ( Lock );
+	if ( Pending.empty () ) {
+		return;
+	}
+	auto position = Pending.find ( Text ( Path ) );
+	if ( position != Pending.end () ) {
+		Wheel[ position->second.Slot ].erase ( position->second.Position );
+		send ( position );
+	}
+}
+
+void Debouncer::FlushAll () {
+	std::lock_guard<std::mutex> guard ( Lock );
+	expireAll ();
+}
+
+void Debouncer::Stop () {
+	std::thread worker;
+	{
+		std::lock_guard<std::mutex> guard ( Lock );
+		Stopping = true;
+		Closed = true;
+		++Joining;
+		worker = std::move ( Worker );
+	}
+	Ready.notify_all ();
+	if ( worker.joinable () ) {
+		worker.join ();
+	}
+	std::lock_guard<std::mutex> guard ( Lock );
+	if ( --Joining == 0 && !Pending.empty () && !Worker.joinable () ) {
+		start ();
+	}
+}
+
+void Debouncer::Start () {
+	std::lock_guard<std::mutex> guard ( Lock );
+	Closed = false;
+}
+
+void Debouncer::start () {
+	Stopping = false;
+	Worker = std::thread ( &Debouncer::run, this );
+}
+
+// Sleeps until the next tick while something waits and sends the slots that came due, on stop sends all
+// the slots in the order they would have come
+void Debouncer::run () {
+	Tracer::Label ( "Debounce" );
+	std::unique_lock<std::mutex> lock ( Lock );
+	while ( true ) {
+		Ready.wait ( lock, [ this ] {
+			return Stopping || !Pending.empty ();
+		} );
+		if ( Stopping ) {
+			expireAll ();
+			return;
+		}
+		Ready.wait_until ( lock, Origin + Tick * ( Done + 1 ), [ this ] {
+			return Stopping;
+		} );
+		for ( auto current = now (); Done < current && !Pending.empty (); ) {
+			expire ( static_cast<size_t> ( ++Done % Slots ) );
+		}
+	}
+}
+
+uint64_t Debouncer::now () const {
+	return static_cast<uint64_t> ( ( Clock::now () - Origin ) / Tick );
+}
+
+void Debouncer::expire ( size_t Slot ) {
+	auto& slot = Wheel[ Slot ];
+	while ( !slot.empty () ) {
+		auto position = Pending.find ( *slot.front () );
+		slot.pop_front ();
+		send ( position );
+	}
+}
+
+// All the slots from the next tick on, in the order they would have come
+void Debouncer::expireAll () {
+	for ( size_t i = 1; i <= Slots && !Pending.empty (); ++i ) {
+		expire ( static_cast<size_t> ( ( Done + i ) % Slots ) );
+	}
+}
+
+void Debouncer::send ( std::unordered_map<Text, Entry, Hash>::iterator Position ) {
+	Target ( Position->second.Net, Position->second.Folder, Position->first );
+	Pending.erase ( Position );
+}
+
+// False when the changes cancel out
+bool Debouncer::merge ( Change& Net, Change Event ) {
+	auto gone = Net == Change::Removed || Net == Change::RenamedOld;
+	switch ( Event ) {
+		case Change::Added:
+		case Change::RenamedNew:
+		case Change::Changed:
+			// Something is at the path again after it was gone, editors save so
+			if ( gone ) {
+				Net = Change::Changed;
+			}
+			return true;
+		case Change::Removed:
+		case Change::RenamedOld:
+			// Gone again before 1C heard it came, by creation or by a move in
+			if ( Net == Change::Added || Net == Change::RenamedNew ) {
+				return false;
+			}
+			Net = Event;
+			return true;
+	}
+	return true;
+}
+
+size_t Debouncer::Hash::operator() ( const Text& Path ) const {
+	uint64_t result { 14695981039346656037ull };
+	for ( auto unit : Path ) {
+		result = ( result ^ unit ) * 1099511628211ull;
+	}
+	return static_cast<size_t> ( result );
+}
@@ -0,0 +1,82 @@
+#ifndef __debounce_h__
+#define __debounce_h__
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "chars.h"
+
+// Folds the changes of a path into one net change, sent once the path stays quiet for the window: an added
+// file that is then changed is sent as added, one added or moved in and then removed or moved out again is
+// not sent at all. A change puts its path into the slot of a timer wheel that comes due after the window, a
+// later change of the path only moves it to a later slot, so a change costs the same whatever number of
+// paths wait
+class Debouncer {
+public:
+	enum class Change { Added, Removed, Changed, RenamedOld, RenamedNew };
+	using Text = std::basic_string<WCHAR_T>;
+	// Called with the lock held, so changes of a path are sent in order with what Flush lets through
+	using Send = std::function<void ( Change Net, bool Folder, const Text& Path )>;
+
+	// Windows up to the span of the wheel, in milliseconds
+	static constexpr long MaxWindow { 10000 };
+
+	explicit Debouncer ( Send Target );
+	~Debouncer ();
+	Debouncer ( const Debouncer& ) = delete;
+	Debouncer& operator= ( const Debouncer& ) = delete;
+
+	void Add ( Chars::View Path, Change Event, bool Folder, long Window );
+	// Sends the change of Path waiting, before something that must not overtake it
+	void Flush ( Chars::View Path );
+	// Sends every change waiting in the order they come due, before something about the whole watch
+	void FlushAll ();
+	// Sends everything waiting and stops the thread, changes that come later are dropped until Start
+	void Stop ();
+	void Start ();
+private:
+	using Clock = std::chrono::steady_clock;
+	static constexpr std::chrono::milliseconds Tick { 10 };
+	static constexpr size_t Slots { 1024 };
+
+	struct Hash {
+		size_t operator() ( const Text& Path ) const;
+	};
+
+	struct Entry {
+		Change Net;
+		bool Folder;
+		size_t Slot;
+		std::list<const Text*>::iterator Position;
+	};
+
+	Send Target;
+	std::mutex Lock;
+	std::condition_variable Ready;
+	std::unordered_map<Text, Entry, Hash> Pending;
+	// Paths by the tick they are due at, modulo the size of the wheel, in the order they got there
+	std::vector<std::list<const Text*>> Wheel;
+	const Clock::time_point Origin;
+	// The last tick whose slot is sent
+	uint64_t Done { 0 };
+	std::thread Worker;
+	bool Stopping { false };
+	bool Closed { false };
+	// Stop calls joining a worker, no other worker starts meanwhile
+	size_t Joining { 0 };
+
+	void start ();
+	void run ();
+	uint64_t now () const;
+	void expire ( size_t Slot );
+	void expireAll ();
+	void send ( std::unordered_map<Text, Entry, Hash>::iterator Position );
+	static bool merge ( Change& Net, Change Event );
+};
+#endif
@@ -0,0 +1,184 @@
+#include "events.h"
+#include <algorithm>
+#include <string>
+#include <utility>
+#include "arena.h"
+#include "json.h"
+#include "trace.h"
+
+Dispatcher::Dispatcher ( Deliver Target ) : Target ( std::move ( Target ) ) {}
+
+Dispatcher::~Dispatcher () {
+	Stop ();
+}
+
+bool Dispatcher::Post ( Chars::View Message, Chars::View Data ) {
+	auto key = hash ( Data );
+	std::unique_lock<std::mutex> lock ( Lock );
+	++Counters.Posted;
+	if ( Closed ) {
+		++Counters.Dropped;
+		return false;
+	}
+	auto coalescing = Tuning.Coalescing.load ( std::memory_order_relaxed );
+	auto latest = [ & ] {
+		auto [ first, last ] = Index.equal_range ( key );
+		for ( auto position = first; position != last; ++position ) {
+			if ( Chars::View ( Pending[ position->second ].Data ) == Data ) {
+				return position;
+			}
+		}
+		return Index.end ();
+	};
+	if ( coalescing ) {
+		auto position = latest ();
+		if ( position != Index.end () && Chars::View ( Pending[ position->second ].Message ) == Message ) {
+			++Counters.Coalesced;
+			return true;
+		}
+	}
+	auto limit = static_cast<size_t> ( Tuning.Limit.load ( std::memory_order_relaxed ) );
+	if ( Pending.size () >= limit && !Room.wait_for ( lock, Patience, [ & ] {
+		return Pending.size () < limit || Closed;
+	} ) ) {
+		++Counters.Dropped;
+		++Unreported;
+		return false;
+	}
+	if ( Closed ) {
+		++Counters.Dropped;
+		return false;
+	}
+	if ( coalescing ) {
+		// Looked up again, the worker may have taken everything while this waited for room
+		auto position = latest ();
+		if ( position != Index.end () ) {
+			position->second = Pending.size ();
+		} else {
+			Index.emplace ( key, Pending.size () );
+		}
+	}
+	Pending.push_back ( { Text ( Message ), Text ( Data ) } );
+	Counters.MaxDepth = std::max<uint64_t> ( Counters.MaxDepth, Pending.size () );
+	if ( !Worker.joinable () ) {
+		start ();
+	}
+	if ( Pending.size () == 1 ) {
+		Ready.notify_one ();
+	}
+	return true;
+}
+
+// The worker is only touched under the lock, Stop takes it out and joins it outside. Posts are refused
+// from then on, so no worker is started again, not even while the destructor joins this one
+void Dispatcher::Stop () {
+	std::thread worker;
+	{
+		std::lock_guard<std::mutex> guard ( Lock );
+		Stopping = true;
+		Closed = true;
+		worker = std::move ( Worker );
+	}
+	Ready.notify_all ();
+	Room.notify_all ();
+	if ( worker.joinable () ) {
+		worker.join ();
+	}
+}
+
+void Dispatcher::start () {
+	Stopping = false;
+	Worker = std::thread ( &Dispatcher::run, this );
+}
+
+Dispatcher::Metrics Dispatcher::Measure () {
+	std::lock_guard<std::mutex> guard ( Lock );
+	auto result = Counters;
+	result.Depth = Pending.size ();
+	return result;
+}
+
+// Waits for the first event, with Latency set gives the rest that long to gather, then delivers all of
+// them outside the lock
+void Dispatcher::run () {
+	Tracer::Label ( "Events" );
+	std::vector<Event> taken;
+	std::unique_lock<std::mutex> lock ( Lock );
+	while ( true ) {
+		Ready.wait ( lock, [ this ] {
+			return Stopping || !Pending.empty () || Unreported;
+		} );
+		auto latency = Tuning.Latency.load ( std::memory_order_relaxed );
+		if ( !Stopping && latency > 0 ) {
+			Ready.wait_for ( lock, std::chrono::milliseconds ( latency ), [ this ] {
+				return Stopping;
+			} );
+		}
+		taken.swap ( Pending );
+		Index.clear ();
+		auto dropped = std::exchange ( Unreported, 0 );
+		auto stopping = Stopping;
+		lock.unlock ();
+		Room.notify_all ();
+		deliver ( taken, dropped, latency > 0 );
+		taken.clear ();
+		lock.lock ();
+		if ( stopping && Pending.empty () && !Unreported ) {
+			return;
+		}
+	}
+}
+
+// One by one, or in ###B### batches of at most Budget units when Latency is set
+void Dispatcher::deliver ( std::vector<Event>& Events, uint64_t Dropped, bool Batching ) {
+	Tracer::Span span ( L"Deliver", "events" );
+	Arena::Scope scope;
+	uint64_t delivered { 0 }, batches { 0 };
+	auto send = [ & ] ( Event* First, Event* Last ) {
+		if ( Last - First == 1 ) {
+			Target ( First->Message.c_str (), First->Data.c_str () );
+		} else {
+			JSON::Writer<WCHAR_T> json ( &Arena::Local () );
+			std::wstring message, data;
+			json.BeginArray ();
+			for ( auto event = First; event != Last; ++event ) {
+				json.BeginObject ().Key ( L"Event" ).String ( Chars::Widen ( event->Message, message ) );
+				json.Key ( L"Data" ).String ( Chars::Widen ( event->Data, data ) ).EndObject ();
+			}
+			json.EndArray ();
+			Target ( BatchSignature, json.Text ().c_str () );
+			++batches;
+		}
+		delivered += static_cast<uint64_t> ( Last - First );
+	};
+	auto first = Events.data ();
+	size_t size { 0 };
+	for ( auto& event : Events ) {
+		auto length = event.Message.size () + event.Data.size () + 24;
+		if ( &event != first && ( !Batching || size + length > Budget ) ) {
+			send ( first, &event );
+			first = &event;
+			size = 0;
+		}
+		size += length;
+	}
+	if ( !Events.empty () ) {
+		send ( first, Events.data () + Events.size () );
+	}
+	if ( Dropped ) {
+		auto count = std::to_string ( Dropped );
+		Text text ( count.begin (), count.end () );
+		Target ( DroppedSignature, text.c_str () );
+	}
+	std::lock_guard<std::mutex> guard ( Lock );
+	Counters.Delivered += delivered;
+	Counters.Batches += batches;
+}
+
+uint64_t Dispatcher::hash ( Chars::View Data ) {
+	uint64_t result { 14695981039346656037ull };
+	for ( auto unit : Data ) {
+		result = ( result ^ unit ) * 1099511628211ull;
+	}
+	return result;
+}
@@ -0,0 +1,91 @@
+#ifndef __events_h__
+#define __events_h__
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "chars.h"
+
+// Everything a component reports to 1C from background threads goes through here instead of calling
+// ExternalEvent on the producer's thread. By default every event is delivered as it is, in order. With
+// Latency set events wait up to that long and what piles up goes out as one ###B### event whose data is a
+// JSON array of {"Event", "Data"} objects, at most Budget units long, a lone event still as it is. With
+// Coalescing on an event is dropped when the latest event waiting with the same data is equal to it, so
+// a repeat never jumps over a different event about the same thing. When Limit events wait, producers
+// wait for room up to Patience and then drop, the number dropped is reported by a ###D### event once the
+// queue has room again
+class Dispatcher {
+public:
+	using Deliver = std::function<void ( const WCHAR_T* Message, const WCHAR_T* Data )>;
+	using Text = std::basic_string<WCHAR_T>;
+
+	struct Metrics {
+		uint64_t Depth;
+		uint64_t MaxDepth;
+		uint64_t Posted;
+		uint64_t Coalesced;
+		uint64_t Dropped;
+		// Events, a batch counts as many as it carries and a ###D### report as none
+		uint64_t Delivered;
+		// ###B### events sent
+		uint64_t Batches;
+	};
+
+	// Set through the component properties, taken as events come, Latency in milliseconds
+	struct Settings {
+		std::atomic<long> Limit { 10000 };
+		std::atomic<long> Latency { 0 };
+		std::atomic<bool> Coalescing { false };
+	};
+
+	explicit Dispatcher ( Deliver Target );
+	~Dispatcher ();
+	Dispatcher ( const Dispatcher& ) = delete;
+	Dispatcher& operator= ( const Dispatcher& ) = delete;
+
+	// From any thread, false when the event was dropped
+	bool Post ( Chars::View Message, Chars::View Data );
+	// Delivers what is waiting and stops the thread, later events are dropped
+	void Stop ();
+	[[nodiscard]] Metrics Measure ();
+	Settings& Tune () {
+		return Tuning;
+	}
+private:
+	static constexpr size_t Budget { 64 << 10 };
+	static constexpr std::chrono::milliseconds Patience { 50 };
+	static constexpr WCHAR_T BatchSignature[] = { '#', '#', '#', 'B', '#', '#', '#', '\0' };
+	static constexpr WCHAR_T DroppedSignature[] = { '#', '#', '#', 'D', '#', '#', '#', '\0' };
+
+	struct Event {
+		Text Message;
+		Text Data;
+	};
+
+	Deliver Target;
+	Settings Tuning;
+	std::mutex Lock;
+	std::condition_variable Ready;
+	std::condition_variable Room;
+	std::vector<Event> Pending;
+	// Position in Pending of the latest event with the given data, by hash of the data
+	std::unordered_multimap<uint64_t, size_t> Index;
+	std::thread Worker;
+	bool Stopping { false };
+	// Set by Stop, posts are dropped from then on
+	bool Closed { false };
+	uint64_t Unreported { 0 };
+	Metrics Counters {};
+
+	void start ();
+	void run ();
+	void deliver ( std::vector<Event>& Events, uint64_t Dropped, bool Batching );
+	static uint64_t hash ( Chars::View Data );
+};
+#endif
@@ -3,6 +3,7 @@
 #include "root.h"
 #include "watcher.h"
 #include "regex.h"
+#include "jsonParser.h"
 #if _WIN32
 [[maybe_unused]]
 BOOL APIENTRY DllMain ( [[maybe_unused]] HMODULE hModule,
@@ -14,7 +15,7 @@ BOOL APIENTRY DllMain ( [[maybe_unused]] HMODULE hModule,
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "OCUnusedGlobalDeclarationInspection"
 
-static const wchar_t ClassNames[] ( L"Root|Watcher|Regex" );
+static const wchar_t ClassNames[] ( L"Root|Watcher|Regex|JSONParser" );
 static AppCapabilities ApplicationCapabilities { AppCapabilitiesInvalid };
 static WCHAR_T* Names {};
 
@@ -22,17 +23,19 @@ long GetClassObject ( const WCHAR_T* Name, IComponentBase** Interface ) {
 	if ( *Interface ) {
 		return 0;
 	}
-	auto name { Chars::WCHARToWide ( Name ) };
-	if ( name == L"Root" ) {
+	auto name = Chars::ToView ( Name );
+	if ( Chars::Same ( name, L"Root" ) ) {
 		*Interface = new Root ();
-	} else if ( name == L"Watcher" ) {
+	} else if ( Chars::Same ( name, L"Watcher" ) ) {
 		try {
 			*Interface = new Watcher ();
 		} catch ( ... ) {
 			return 0;
 		}
-	} else if ( name == L"Regex" ) {
+	} else if ( Chars::Same ( name, L"Regex" ) ) {
 		*Interface = new Regex ();
+	} else if ( Chars::Same ( name, L"JSONParser" ) ) {
+		*Interface = new JSONParser ();
 	}
 	return reinterpret_cast<long>(*Interface);
 }
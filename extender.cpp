@@ -1,6 +1,11 @@
 #include "extender.h"
+#include <algorithm>
+#include <cassert>
 #include <chrono>
+#include <cstdlib>
 #include <mutex>
+#include "pool.h"
+#include "transform.h"
 #ifdef __linux__
 #include <cwchar>
 #include <utility>
@@ -8,25 +13,97 @@
 #include <clocale>
 #endif
 
-Extender::Extender ( const std::wstring& Extension )
-		: memoryManager ( nullptr ), baseConnector ( nullptr ) {
+namespace {
+	// String and binary payload of the values, what Stats reports as bytes in and out
+	uint64_t payload ( const tVariant* Values, long Count ) {
+		uint64_t result { 0 };
+		for ( long i = 0; i < Count; ++i ) {
+			if ( Values[ i ].vt == VTYPE_PWSTR ) {
+				result += Values[ i ].wstrLen * sizeof ( WCHAR_T );
+			} else if ( Values[ i ].vt == VTYPE_BLOB ) {
+				result += Values[ i ].strLen;
+			}
+		}
+		return result;
+	}
+
+	// Results of calls on the pool are read by the component itself, 1C never sees that memory
+	class Heap : public imemorymanager {
+	public:
+		bool ADDIN_API AllocMemory ( void** Memory, unsigned long Bytes ) override {
+			*Memory = std::malloc ( Bytes );
+			return *Memory != nullptr;
+		}
+
+		void ADDIN_API FreeMemory ( void** Memory ) override {
+			std::free ( *Memory );
+			*Memory = nullptr;
+		}
+	} heap;
+
+	// Set while the thread runs a MethodAsync call, whose errors go out with its completion event
+	thread_local std::wstring* background { nullptr };
+
+	// A result in the completion event, pictures and other binary data as base64
+	void value ( JSON::Writer<WCHAR_T>& Json, const tVariant& Value ) {
+		switch ( Value.vt ) {
+			case VTYPE_PWSTR: {
+				std::wstring buffer;
+				Json.String ( Chars::Widen ( Chars::View ( Value.pwstrVal, Value.wstrLen ), buffer ) );
+				break;
+			}
+			case VTYPE_BLOB:
+				Json.String ( strings::toBase64 ( { Value.pstrVal, Value.strLen } ) );
+				break;
+			case VTYPE_BOOL:
+				Json.Bool ( Value.bVal );
+				break;
+			case VTYPE_I4:
+				Json.Number ( static_cast<int64_t> ( Value.lVal ) );
+				break;
+			case VTYPE_R8:
+				Json.Number ( Value.dblVal );
+				break;
+			default:
+				Json.Null ();
+		}
+	}
+}
+
+struct Extender::Job {
+	enum : int { Waiting, Running, Cancelled };
+
+	uint64_t Id { 0 };
+	long Method;
+	std::vector<tVariant> Params;
+	std::vector<std::basic_string<WCHAR_T>> Texts;
+	std::vector<std::string> Bytes;
+	std::atomic<int> State { Waiting };
+};
+
+Extender::Extender ( const std::wstring& Extension, Methods Table, Properties Fields )
+		: methods ( Table ), properties ( Fields ), memoryManager ( nullptr ), baseConnector ( nullptr ),
+		  Stats ( Table.Size () ), Events ( [ this ] ( const WCHAR_T* Message, const WCHAR_T* Data ) {
+			  if ( baseConnector ) {
+				  baseConnector->ExternalEvent ( ExtensionID, Message, Data );
+			  }
+		  } ) {
 	ExtensionID = nullptr;
 	Chars::ToWCHAR ( &ExtensionID, Extension.data () );
-	methods.AddFunction ( L"Version", L"Версия", 0, [ & ] ( tVariant* Params, tVariant* Result ) {
-		version ( Result );
-		return true;
-	} );
-	methods.AddFunction ( L"Problem", L"Проблема", 0, [ & ] ( tVariant* Params, tVariant* Result ) {
-		getLastError ( Result );
-		return true;
-	} );
-	methods.AddFunction ( L"Error", L"Ошибка", 0, [ & ] ( tVariant* Params, tVariant* Result ) {
-		isError ( Result );
-		return true;
-	} );
+	Background = Accounting::Tag ( Extension, {} );
+	for ( size_t i = 0; i < methods.Size (); ++i ) {
+		auto method = methods.Get ( static_cast<long> ( i ) );
+		if ( method->Concurrent ) {
+			Companions.push_back ( static_cast<long> ( i ) );
+		}
+		Allocations.push_back ( Accounting::Tag ( Extension, method->English ) );
+	}
 }
 
+// Done or the destructor of the component has drained the pool calls by now, they use the component
 Extender::~Extender () {
+	assert ( Jobs.empty () );
+	Events.Stop ();
 	delete[] ExtensionID;
 }
 
@@ -71,6 +148,11 @@ bool Extender::Init ( void* Connection ) {
 	return baseConnector != nullptr;
 }
 
+Extender::Properties Extender::listProperties () {
+	static constexpr auto list = fields ();
+	return list;
+}
+
 bool Extender::setMemManager ( void* Pointer ) {
 	memoryManager = static_cast<imemorymanager*>( Pointer );
 	return memoryManager != nullptr;
@@ -85,83 +167,186 @@ bool Extender::RegisterExtensionAs ( WCHAR_T** Entry ) {
 }
 
 bool Extender::allocate ( const WCHAR_T* Source, WCHAR_T** Destination ) const {
-	if ( !memoryManager ) {
+	return copy ( Chars::ToView ( Source ), Destination );
+}
+
+bool Extender::allocate ( Chars::View Source, WCHAR_T** Destination ) const {
+	return copy ( Source, Destination );
+}
+
+#ifdef __linux__
+bool Extender::allocate ( std::wstring_view Source, WCHAR_T** Destination ) const {
+	return copy ( Source, Destination );
+}
+#endif
+
+template <typename Unit>
+bool Extender::copy ( std::basic_string_view<Unit> Source, WCHAR_T** Destination ) const {
+	auto manager = memory ();
+	if ( !manager ) {
 		return false;
 	}
-	auto size = Chars::WCHARLength ( Source ) + 1;
-	if ( !memoryManager->AllocMemory ( reinterpret_cast<void**>( Destination ), size * sizeof ( WCHAR_T ) ) ) {
+	auto size = ( Source.size () + 1 ) * sizeof ( WCHAR_T );
+	if ( !manager->AllocMemory ( reinterpret_cast<void**>( Destination ), size ) ) {
 		return false;
 	}
-	auto to = *Destination;
-	while ( size-- ) *to++ = *Source++;
+	*std::copy ( Source.begin (), Source.end (), *Destination ) = 0;
 	return true;
 }
 
 long Extender::GetNProps () {
-	return properties.Count;
+	return static_cast<long> ( properties.Size () );
 }
 
 long Extender::FindProp ( const WCHAR_T* Name ) {
-	return properties.GetIndex ( Chars::FromWCHAR ( Name ).get () );
+	return properties.Find ( Chars::ToView ( Name ) );
 }
 
 const WCHAR_T* Extender::GetPropName ( long Property, long Lang ) {
-	return getName ( properties.PropertyKeys, properties.PropertyKeysRu, Property, Lang );
+	auto property = properties.Get ( Property );
+	return property ? getName ( property->English, property->Russian, Lang ) : nullptr;
 }
 
 bool Extender::GetPropVal ( long Property, tVariant* Value ) {
-	return false;
+	auto property = properties.Get ( Property );
+	if ( !property || !property->Get ) return false;
+	Arena::Scope scope;
+	return property->Get ( *this, Value );
 }
 
 bool Extender::SetPropVal ( long Property, tVariant* Value ) {
-	return false;
+	auto property = properties.Get ( Property );
+	if ( !property || !property->Set ) return false;
+	Arena::Scope scope;
+	return property->Set ( *this, Value );
+}
+
+bool Extender::isNumber ( const tVariant* Value ) {
+	switch ( Value->vt ) {
+		case VTYPE_I1:
+		case VTYPE_I2:
+		case VTYPE_I4:
+		case VTYPE_I8:
+		case VTYPE_UI1:
+		case VTYPE_UI2:
+		case VTYPE_UI4:
+		case VTYPE_UI8:
+		case VTYPE_INT:
+		case VTYPE_UINT:
+		case VTYPE_R4:
+		case VTYPE_R8:
+			return true;
+		default:
+			return false;
+	}
+}
+
+// 1C keeps the depth per connection, a new one applies at once
+void Extender::applyBufferDepth () {
+	if ( baseConnector ) {
+		baseConnector->SetEventBufferDepth ( YellowBuffer );
+	}
 }
 
 bool Extender::IsPropReadable ( long Property ) {
-	return false;
+	auto property = properties.Get ( Property );
+	return property && property->Get;
 }
 
 bool Extender::IsPropWritable ( long Property ) {
-	return false;
+	auto property = properties.Get ( Property );
+	return property && property->Set;
 }
 
 long Extender::GetNMethods () {
-	return methods.Count;
+	return static_cast<long> ( methods.Size () + Companions.size () );
 }
 
 long Extender::FindMethod ( const WCHAR_T* Name ) {
-	return getIndex ( methods.Methods, methods.MethodsRu, Chars::FromWCHAR ( Name ).get () );
+	auto name = Chars::ToView ( Name );
+	auto found = methods.Find ( name );
+	if ( found >= 0 ) {
+		return found;
+	}
+	for ( std::wstring_view suffix : { L"Async", L"Асинх" } ) {
+		if ( name.size () <= suffix.size () || !registry::same ( name.substr ( name.size () - suffix.size () ), suffix ) ) {
+			continue;
+		}
+		auto companion = std::find ( Companions.begin (), Companions.end (),
+									 methods.Find ( name.substr ( 0, name.size () - suffix.size () ) ) );
+		if ( companion != Companions.end () ) {
+			return static_cast<long> ( methods.Size () + ( companion - Companions.begin () ) );
+		}
+	}
+	return -1;
 }
 
 const WCHAR_T* Extender::GetMethodName ( long Method, long Lang ) {
-	return getName ( methods.MethodKeys, methods.MethodKeysRu, Method, Lang );
+	auto method = methods.Get ( base ( Method ) );
+	if ( !method ) {
+		return nullptr;
+	}
+	if ( Method == base ( Method ) ) {
+		return getName ( method->English, method->Russian, Lang );
+	}
+	Arena::Scope scope;
+	std::pmr::wstring english ( method->English, scratch () );
+	std::pmr::wstring russian ( method->Russian, scratch () );
+	return getName ( english.append ( L"Async" ), russian.append ( L"Асинх" ), Lang );
 }
 
 long Extender::GetNParams ( long Method ) {
-	return methods.Parameters[ Method ];
+	auto method = methods.Get ( base ( Method ) );
+	return method ? method->Parameters : 0;
 }
 
 bool Extender::GetParamDefValue ( long Method, long Parameter, tVariant* Default ) {
 	TV_VT ( Default ) = VTYPE_EMPTY;
-	return false;
+	auto method = methods.Get ( base ( Method ) );
+	// Trailing optional parameters are passed as VTYPE_EMPTY, handlers check for it
+	return method && Parameter >= method->Parameters - method->Optional;
 }
 
+// A companion returns the id its completion event will carry
 bool Extender::HasRetVal ( long Method ) {
-	return methods.HasResult[ Method ];
+	auto method = methods.Get ( base ( Method ) );
+	return method && ( method->Function || Method != base ( Method ) );
 }
 
+// A function comes here when its value is not used, such a result is freed at once
 bool Extender::CallAsProc ( long Method, tVariant* Params, long Count ) {
 	if ( !checkParams ( Method, Count ) ) return false;
-	return methods.Procedures[ Method ] ( Params );
+	if ( Method != base ( Method ) ) return submit ( base ( Method ), Params, Count, nullptr );
+	Arena::Scope scope;
+	Accounting::Scope account ( Allocations[ Method ] );
+	auto method = methods.Get ( Method );
+	Tracer::Span span ( method->English, "method" );
+	auto start = std::chrono::steady_clock::now ();
+	tVariant result {};
+	auto done = method->Call ( *this, Params, method->Function ? &result : nullptr );
+	Stats.Record ( Method, std::chrono::steady_clock::now () - start, done, payload ( Params, Count ), 0 );
+	if ( memoryManager && ( result.vt == VTYPE_PWSTR || result.vt == VTYPE_BLOB ) ) {
+		memoryManager->FreeMemory ( reinterpret_cast<void**> ( &result.pstrVal ) );
+	}
+	return done;
 }
 
 bool Extender::checkParams ( long Method, long Count ) {
-	return Count == methods.Parameters[ Method ];
+	auto method = methods.Get ( base ( Method ) );
+	return method && Count == method->Parameters;
 }
 
 bool Extender::CallAsFunc ( long Method, tVariant* Result, tVariant* Params, long Count ) {
 	if ( !checkParams ( Method, Count ) ) return false;
-	return methods.Functions[ Method ] ( Params, Result );
+	if ( Method != base ( Method ) ) return submit ( base ( Method ), Params, Count, Result );
+	Arena::Scope scope;
+	Accounting::Scope account ( Allocations[ Method ] );
+	auto method = methods.Get ( Method );
+	Tracer::Span span ( method->English, "method" );
+	auto start = std::chrono::steady_clock::now ();
+	auto done = method->Call ( *this, Params, Result );
+	Stats.Record ( Method, std::chrono::steady_clock::now () - start, done, payload ( Params, Count ), payload ( Result, 1 ) );
+	return done;
 }
 
 void Extender::SetLocale ( const WCHAR_T* Locale ) {
@@ -174,55 +359,22 @@ void Extender::SetLocale ( const WCHAR_T* Locale ) {
 #endif
 }
 
-void Extender::Done () {}
+void Extender::Done () {
+	drain ();
+	Events.Stop ();
+}
 
 void Extender::ShowError ( const char* Message ) const {
+	if ( background ) {
+		*background = Chars::StringToWide ( std::string ( Message ) );
+		return;
+	}
+	Arena::Scope scope;
 	auto size = mbstowcs ( nullptr, Message, 0 ) + 1;
 	assert ( size );
-	auto message = new WCHAR[size];
-	memset ( message, 0, size * sizeof ( wchar_t ) );
-	mbstowcs ( message, Message, size );
-	addError ( ADDIN_E_VERY_IMPORTANT, message, 0 );
-	delete[] message;
-}
-
-[[maybe_unused]]
-void Extender::propertiesList::Add ( const std::wstring& English, const std::wstring& Russian ) {
-	++Count;
-	Properties[ English ] = Count;
-	PropertiesRu[ Russian ] = Count;
-	PropertyKeys[ Count ] = English;
-	PropertyKeysRu[ Count ] = Russian;
-}
-
-long Extender::propertiesList::GetIndex ( const wchar_t* Name ) const {
-	auto value = Properties.find ( Name );
-	if ( value == Properties.end () ) value = PropertiesRu.find ( Name );
-	else return value->second;
-	if ( value == PropertiesRu.end () ) return -1;
-	return value->second;
-}
-
-void
-Extender::methodsList::AddProcedure ( const wchar_t* English, const wchar_t* Russian, int Params, procedure Handler ) {
-	addMethod ( English, Russian, Params, false );
-	Procedures[ Count ] = std::move ( Handler );
-}
-
-void Extender::methodsList::addMethod ( const wchar_t* English, const wchar_t* Russian, int Params, bool Function ) {
-	++Count;
-	Methods[ English ] = Count;
-	MethodsRu[ Russian ] = Count;
-	MethodKeys[ Count ] = English;
-	MethodKeysRu[ Count ] = Russian;
-	HasResult[ Count ] = Function;
-	Parameters[ Count ] = Params;
-}
-
-void Extender::methodsList::AddFunction ( const wchar_t* English, const wchar_t* Russian, int Params,
-										  function Handler ) {
-	addMethod ( English, Russian, Params, true );
-	Functions[ Count ] = std::move ( Handler );
+	std::pmr::wstring message ( size, L'\0', scratch () );
+	mbstowcs ( message.data (), Message, size );
+	addError ( ADDIN_E_VERY_IMPORTANT, message.c_str (), 0 );
 }
 
 [[maybe_unused]]
@@ -239,55 +391,53 @@ long Extender::findName ( const wchar_t* Names[], const wchar_t* Name, uint32_t
 
 void Extender::addError ( uint32_t Code, const wchar_t* Descriptor, long Id ) const {
 	if ( baseConnector ) {
-		baseConnector->AddError ( Code, ExtensionID, Chars::ToWCHAR ( Descriptor ).get (), Id );
+		Arena::Scope scope;
+		baseConnector->AddError ( Code, ExtensionID, Chars::ToWCHAR ( Descriptor, scratch () ).c_str (), Id );
 	}
 }
 
-const WCHAR_T*
-Extender::getName ( std::map<long, std::wstring>& SetEn, std::map<long, std::wstring>& SetRu, long Index,
-					long Lang ) const {
-	const wchar_t* name;
+const WCHAR_T* Extender::getName ( std::wstring_view English, std::wstring_view Russian, long Lang ) const {
+	std::wstring_view name;
 	switch ( Lang ) {
 		case 0:
-			name = SetEn[ Index ].c_str ();
+			name = English;
 			break;
 		case 1:
-			name = SetRu[ Index ].c_str ();
+			name = Russian;
 			break;
 		default:
 			return nullptr;
 	}
-	if ( name[ 0 ] == '\0' ) {
-		return nullptr;
-	}
 	WCHAR_T* yellowName { nullptr };
-	if ( allocate ( Chars::ToWCHAR ( name ).get (), &yellowName ) ) {
+	if ( !name.empty () && allocate ( name, &yellowName ) ) {
 		return yellowName;
 	} else {
 		return nullptr;
 	}
 }
 
-long
-Extender::getIndex ( std::map<std::wstring, int>& SetEn, std::map<std::wstring, int>& SetRu, const wchar_t* Name ) {
-	auto value = SetEn.find ( Name );
-	if ( value == SetEn.end () ) value = SetRu.find ( Name );
-	else return value->second;
-	if ( value == SetRu.end () ) return -1;
-	return value->second;
+void Extender::returnString ( tVariant* Result, Chars::View String ) const {
+	returnUnits ( Result, String );
 }
 
-void Extender::returnString ( tVariant* Result, const std::wstring& String ) const {
-	auto count = 1 + String.size ();
-	auto size = count * sizeof std::wstring::value_type ();
-	if ( !size || !memoryManager->AllocMemory ( reinterpret_cast<void**>( &Result->pwstrVal ), size ) ) return;
 #ifdef __linux__
-	Chars::ToWCHAR ( &Result->pwstrVal, String.data () );
-#elif _WIN32
-	if ( wcscpy_s ( Result->pwstrVal, count, String.c_str () ) ) return;
+void Extender::returnString ( tVariant* Result, std::wstring_view String ) const {
+	returnUnits ( Result, String );
+}
 #endif
+
+template <typename Unit>
+void Extender::returnUnits ( tVariant* Result, std::basic_string_view<Unit> String ) const {
+	if ( !copy ( String, &Result->pwstrVal ) ) return;
 	Result->vt = VTYPE_PWSTR;
-	Result->wstrLen = count - 1;
+	Result->wstrLen = String.size ();
+}
+
+void Extender::returnBlob ( tVariant* Result, std::string_view Data ) const {
+	if ( Data.empty () || !memory ()->AllocMemory ( reinterpret_cast<void**>( &Result->pstrVal ), Data.size () ) ) return;
+	std::copy ( Data.begin (), Data.end (), Result->pstrVal );
+	Result->strLen = Data.size ();
+	Result->vt = VTYPE_BLOB;
 }
 
 void Extender::returnBool ( tVariant* Result, bool Value ) {
@@ -295,18 +445,243 @@ void Extender::returnBool ( tVariant* Result, bool Value ) {
 	Result->bVal = Value;
 }
 
-void Extender::version ( tVariant* Result ) {
+void Extender::version ( tVariant*, tVariant* Result ) {
 	Result->llVal = GetInfo ();
 	Result->vt = VTYPE_I4;
 }
 
-void Extender::getLastError ( tVariant* Result ) {
+void Extender::getLastError ( tVariant*, tVariant* Result ) {
 	if ( !LastError.empty () ) {
 		returnString ( Result, LastError );
 		LastError.clear ();
 	}
 }
 
-void Extender::isError ( tVariant* Result ) {
+void Extender::isError ( tVariant*, tVariant* Result ) {
 	returnBool ( Result, !LastError.empty () );
 }
+
+void Extender::avoided ( tVariant*, tVariant* Result ) {
+	Result->dblVal = static_cast<double> ( Arena::Avoided () );
+	Result->vt = VTYPE_R8;
+}
+
+// Object keyed by names of the methods called since the start or ResetStats, times in nanoseconds
+void Extender::getStats ( tVariant*, tVariant* Result ) {
+	returnStructure ( Result, JSON::Encoding::Text, [ & ] ( auto& json ) {
+		json.BeginObject ();
+		for ( size_t i = 0; i < methods.Size (); ++i ) {
+			auto summary = Stats.Summarize ( i );
+			if ( !summary.Calls ) {
+				continue;
+			}
+			json.Key ( methods.Get ( static_cast<long> ( i ) )->English ).BeginObject ();
+			for ( auto [ name, value ] : { std::pair { L"Calls", summary.Calls }, { L"Errors", summary.Errors },
+										   { L"BytesIn", summary.BytesIn }, { L"BytesOut", summary.BytesOut },
+										   { L"Total", summary.Total }, { L"Mean", summary.Mean },
+										   { L"P50", summary.P50 }, { L"P95", summary.P95 },
+										   { L"P99", summary.P99 }, { L"Max", summary.Max } } ) {
+				json.Key ( name ).Number ( static_cast<int64_t> ( value ) );
+			}
+			json.EndObject ();
+		}
+		json.EndObject ();
+	} );
+}
+
+void Extender::resetStats () {
+	Stats.Reset ();
+}
+
+// Tracing is one for the process, any component starts and stops it for all of them
+void Extender::startTrace () {
+	Tracer::Start ();
+}
+
+// Chrome trace events of method calls and background work since StartTrace
+void Extender::stopTrace ( tVariant*, tVariant* Result ) {
+	Tracer::Stop ();
+	JSON::Writer<WCHAR_T> json ( scratch () );
+	Tracer::Write ( json );
+	returnString ( Result, json.View () );
+}
+
+imemorymanager* Extender::memory () const {
+	return background ? &heap : memoryManager;
+}
+
+std::wstring& Extender::error () {
+	return background ? *background : LastError;
+}
+
+// The table position of a method, or of the one a companion submits
+long Extender::base ( long Method ) const {
+	auto size = static_cast<long> ( methods.Size () );
+	if ( Method < size ) {
+		return Method;
+	}
+	auto companion = static_cast<size_t> ( Method - size );
+	return companion < Companions.size () ? Companions[ companion ] : -1;
+}
+
+// Arguments are copied, 1C frees its own once the call returns. A full pool is an error right away
+bool Extender::submit ( long Method, tVariant* Params, long Count, tVariant* Result ) {
+	auto job = std::make_shared<Job> ();
+	job->Method = Method;
+	job->Params.assign ( Params, Params + Count );
+	job->Texts.reserve ( Count );
+	job->Bytes.reserve ( Count );
+	for ( auto& param : job->Params ) {
+		if ( param.vt == VTYPE_PWSTR ) {
+			param.pwstrVal = job->Texts.emplace_back ( Chars::View ( param.pwstrVal, param.wstrLen ) ).data ();
+		} else if ( param.vt == VTYPE_PSTR || param.vt == VTYPE_BLOB ) {
+			param.pstrVal = job->Bytes.emplace_back ( std::string_view ( param.pstrVal, param.strLen ) ).data ();
+		}
+	}
+	{
+		std::lock_guard<std::mutex> guard ( JobsLock );
+		job->Id = ++LastJob;
+		Jobs.emplace ( job->Id, job );
+	}
+	auto accepted = Pool::Shared ().Submit ( [ this, job ] {
+		int waiting { Job::Waiting };
+		if ( job->State.compare_exchange_strong ( waiting, Job::Running ) ) {
+			complete ( *job );
+		}
+	} );
+	if ( !accepted ) {
+		{
+			std::lock_guard<std::mutex> guard ( JobsLock );
+			Jobs.erase ( job->Id );
+		}
+		SetError ( "Too many asynchronous calls are waiting, try again later" );
+		return false;
+	}
+	if ( Result ) {
+		Result->dblVal = static_cast<double> ( job->Id );
+		Result->vt = VTYPE_R8;
+	}
+	return true;
+}
+
+// Runs on the pool and reports with the ###A### event, its data is an object with Id, Method,
+// Success, the Result of a function and the Error text if there was one
+void Extender::complete ( Job& Task ) {
+	Arena::Scope scope;
+	Accounting::Scope account ( Allocations[ Task.Method ] );
+	auto method = methods.Get ( Task.Method );
+	Tracer::Span span ( method->English, "async" );
+	std::wstring problem;
+	background = &problem;
+	tVariant result {};
+	auto start = std::chrono::steady_clock::now ();
+	bool done { false };
+	try {
+		done = method->Call ( *this, Task.Params.data (), method->Function ? &result : nullptr );
+	} catch ( const std::exception& E ) {
+		problem = Chars::StringToWide ( E.what () );
+	}
+	Stats.Record ( Task.Method, std::chrono::steady_clock::now () - start, done,
+				   payload ( Task.Params.data (), static_cast<long> ( Task.Params.size () ) ), payload ( &result, 1 ) );
+	background = nullptr;
+	JSON::Writer<WCHAR_T> json ( scratch () );
+	json.BeginObject ().Key ( L"Id" ).Number ( static_cast<int64_t> ( Task.Id ) );
+	json.Key ( L"Method" ).String ( method->English ).Key ( L"Success" ).Bool ( done );
+	if ( method->Function ) {
+		json.Key ( L"Result" );
+		value ( json, result );
+	}
+	if ( !problem.empty () ) {
+		json.Key ( L"Error" ).String ( problem );
+	}
+	json.EndObject ();
+	if ( result.vt == VTYPE_PWSTR || result.vt == VTYPE_BLOB ) {
+		heap.FreeMemory ( reinterpret_cast<void**> ( &result.pstrVal ) );
+	}
+	Post ( AsyncSignature, json.View () );
+	// The component may be gone as soon as the lock is released
+	std::lock_guard<std::mutex> guard ( JobsLock );
+	Jobs.erase ( Task.Id );
+	JobsDone.notify_all ();
+}
+
+void Extender::drain () {
+	std::unique_lock<std::mutex> lock ( JobsLock );
+	for ( auto job = Jobs.begin (); job != Jobs.end (); ) {
+		int waiting { Job::Waiting };
+		if ( job->second->State.compare_exchange_strong ( waiting, Job::Cancelled ) ) {
+			job = Jobs.erase ( job );
+		} else {
+			++job;
+		}
+	}
+	JobsDone.wait ( lock, [ this ] {
+		return Jobs.empty ();
+	} );
+}
+
+// True when the call had not started, it is then dropped without a completion event
+bool Extender::cancel ( tVariant* Params, tVariant* Result ) {
+	auto id = static_cast<uint64_t> ( getNumber ( Params ) );
+	auto cancelled { false };
+	{
+		std::lock_guard<std::mutex> guard ( JobsLock );
+		auto job = Jobs.find ( id );
+		int waiting { Job::Waiting };
+		if ( job != Jobs.end () && job->second->State.compare_exchange_strong ( waiting, Job::Cancelled ) ) {
+			Jobs.erase ( job );
+			cancelled = true;
+		}
+	}
+	returnBool ( Result, cancelled );
+	return true;
+}
+
+// Depth is what waits now, the rest counts since the component was created
+void Extender::getEventStats ( tVariant*, tVariant* Result ) {
+	auto metrics = Events.Measure ();
+	returnStructure ( Result, JSON::Encoding::Text, [ & ] ( auto& json ) {
+		json.BeginObject ();
+		for ( auto [ name, value ] : { std::pair { L"Depth", metrics.Depth }, { L"MaxDepth", metrics.MaxDepth },
+									   { L"Posted", metrics.Posted }, { L"Coalesced", metrics.Coalesced },
+									   { L"Dropped", metrics.Dropped }, { L"Delivered", metrics.Delivered },
+									   { L"Batches", metrics.Batches } } ) {
+			json.Key ( name ).Number ( static_cast<int64_t> ( value ) );
+		}
+		json.EndObject ();
+	} );
+}
+
+// Bytes are requested sizes. Allocations, Frees and Bytes count since the module was loaded, Live is
+// what is not freed yet and Peak the most Live ever was. Methods are those that allocated, Background is
+// the threads of the component, Process all of the module
+void Extender::getMemoryStats ( tVariant*, tVariant* Result ) {
+	returnStructure ( Result, JSON::Encoding::Text, [ & ] ( auto& json ) {
+		auto write = [ & ] ( const Accounting::Summary& Summary ) {
+			json.BeginObject ();
+			for ( auto [ name, value ] : { std::pair { L"Allocations", Summary.Allocations }, { L"Frees", Summary.Frees },
+										   { L"Bytes", Summary.Bytes }, { L"Live", Summary.Live },
+										   { L"Peak", Summary.Peak } } ) {
+				json.Key ( name ).Number ( static_cast<int64_t> ( value ) );
+			}
+			json.EndObject ();
+		};
+		json.BeginObject ().Key ( L"Enabled" ).Bool ( Accounting::Enabled );
+		if ( Accounting::Enabled ) {
+			json.Key ( L"Process" );
+			write ( Accounting::Summarize ( nullptr ) );
+			json.Key ( L"Background" );
+			write ( Accounting::Summarize ( Background ) );
+			json.Key ( L"Methods" ).BeginObject ();
+			for ( size_t i = 0; i < methods.Size (); ++i ) {
+				auto summary = Accounting::Summarize ( Allocations[ i ] );
+				if ( summary.Allocations ) {
+					json.Key ( methods.Get ( static_cast<long> ( i ) )->English );
+					write ( summary );
+				}
+			}
+			json.EndObject ();
+		}
+		json.EndObject ();
+	} );
+}
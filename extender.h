@@ -1,25 +1,62 @@
 #ifndef __addin_h__
 #define __addin_h__
-#include <functional>
-#include <map>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 #include "1c/componentbase.h"
 #include "1c/addindefbase.h"
 #include "1c/imemorymanager.h"
+#include "accounting.h"
+#include "arena.h"
 #include "chars.h"
+#include "events.h"
+#include "json.h"
+#include "registry.h"
+#include "stats.h"
+#include "trace.h"
 #define BASE_ERRNO 7
 
 class Extender : public IComponentBase {
 public:
-	typedef std::function<bool ( tVariant* Params )> procedure;
-	typedef std::function<bool ( tVariant* Params, tVariant* Result )> function;
+	// Procedures are called with a null Result
+	struct Method {
+		std::wstring_view English;
+		std::wstring_view Russian;
+		int Parameters;
+		int Optional;
+		bool Function;
+		bool ( *Call ) ( Extender& Self, tVariant* Params, tVariant* Result );
+		// Safe to run on the pool next to other calls, such a method gets a MethodAsync companion
+		bool Concurrent { false };
+	};
+
+	// Null Get or Set makes the property write-only or read-only
+	struct Property {
+		std::wstring_view English;
+		std::wstring_view Russian;
+		bool ( *Get ) ( Extender& Self, tVariant* Value );
+		bool ( *Set ) ( Extender& Self, tVariant* Value );
+	};
 
-	explicit Extender ( const std::wstring& Extension );
+	using Methods = registry::Registry<Method>;
+	using Properties = registry::Registry<Property>;
+
+	Extender ( const std::wstring& Extension, Methods Table, Properties Fields = listProperties () );
 	~Extender () override;
 	bool ADDIN_API Init ( void* Connection ) override;
 	bool ADDIN_API setMemManager ( void* Pointer ) override;
 	long ADDIN_API GetInfo () override;
 	bool ADDIN_API RegisterExtensionAs ( WCHAR_T** Entry ) override;
 	bool allocate ( const WCHAR_T* Source, WCHAR_T** Destination ) const;
+	// Text already in 1C units goes over with one bulk copy, wchar_t text is narrowed on the way
+	bool allocate ( Chars::View Source, WCHAR_T** Destination ) const;
+#ifdef __linux__
+	bool allocate ( std::wstring_view Source, WCHAR_T** Destination ) const;
+#endif
 	long ADDIN_API GetNProps () override;
 	long ADDIN_API FindProp ( const WCHAR_T* Name ) override;
 	const WCHAR_T* ADDIN_API GetPropName ( long Property, long Lang ) override;
@@ -42,15 +79,16 @@ public:
 	template <typename T>
 	void SetError ( const T& Message ) {
 		if constexpr ( std::is_same_v<T, std::wstring> ) {
-			LastError = Message;
+			error () = Message;
 		} else if constexpr ( std::is_same_v<T, const char*> ) {
-			LastError = Chars::StringToWide ( std::string ( Message ) );
+			error () = Chars::StringToWide ( std::string ( Message ) );
 		} else {
-			LastError = Chars::StringToWide ( Message );
+			error () = Chars::StringToWide ( Message );
 		}
 	}
 	template <typename T>
 	void SendError ( const T& Message ) {
+		Arena::Scope scope;
 		std::wstring text;
 		if constexpr ( std::is_same_v<T, std::wstring> ) {
 			text = Message;
@@ -59,58 +97,311 @@ public:
 		} else {
 			text = Chars::StringToWide ( Message );
 		}
-		baseConnector->ExternalEvent ( ExtensionID, ErrorSignature, Chars::ToWCHAR ( text.data () ).get () );
+		Post ( ErrorSignature, Chars::ToWCHAR ( text, scratch () ) );
+	}
+	// Events for 1C from any thread, see Dispatcher
+	bool Post ( Chars::View Message, Chars::View Data ) {
+		return Events.Post ( Message, Data );
 	}
 protected:
-	struct propertiesList {
-		int Count { 0 };
-		std::map<std::wstring, long> Properties;
-		std::map<std::wstring, long> PropertiesRu;
-		std::map<long, std::wstring> PropertyKeys;
-		std::map<long, std::wstring> PropertyKeysRu;
-
-		[[maybe_unused]] void Add ( const std::wstring& English, const std::wstring& Russian );
-		long GetIndex ( const wchar_t* Name ) const;
-	};
+	// Table entries. Handler is a member or a static function taking ( Params, Result ), ( Params )
+	// or nothing, returning the success flag or void for always
+	template <auto Handler>
+	static constexpr Method function ( std::wstring_view English, std::wstring_view Russian, int Parameters,
+									   int Optional = 0 ) {
+		return { English, Russian, Parameters, Optional, true, call<Handler> };
+	}
 
-	struct methodsList {
-		int Count { 0 };
-		std::map<std::wstring, int> Methods;
-		std::map<std::wstring, int> MethodsRu;
-		std::map<long, std::wstring> MethodKeys;
-		std::map<long, std::wstring> MethodKeysRu;
-		std::map<long, bool> HasResult;
-		std::map<long, int> Parameters;
-		std::map<long, procedure> Procedures;
-		std::map<long, function> Functions;
-
-		void AddProcedure ( const wchar_t* English, const wchar_t* Russian, int Parameters, procedure Handler );
-		void addMethod ( const wchar_t* English, const wchar_t* Russian, int Params, bool Function );
-		void AddFunction ( const wchar_t* English, const wchar_t* Russian, int Parameters, function Handler );
-	};
+	template <auto Handler>
+	static constexpr Method procedure ( std::wstring_view English, std::wstring_view Russian, int Parameters,
+										int Optional = 0 ) {
+		return { English, Russian, Parameters, Optional, false, call<Handler> };
+	}
+
+	// A component with concurrent entries calls drain in its own destructor, a call still running on the pool
+	// reads its members
+	static constexpr Method concurrent ( Method Entry ) {
+		Entry.Concurrent = true;
+		return Entry;
+	}
+
+	// Properties over a member of the component, or over a member function returning one. A number is
+	// std::atomic<long> kept between Minimum and Maximum, a flag std::atomic<bool>, a text std::wstring that
+	// Valid accepts. Changed is a member function called once a new value is set
+	template <auto Field, long Minimum, long Maximum, auto Changed = nullptr>
+	static constexpr Property number ( std::wstring_view English, std::wstring_view Russian ) {
+		return { English, Russian, readNumber<Field>, writeNumber<Field, Minimum, Maximum, Changed> };
+	}
+
+	template <auto Field, auto Changed = nullptr>
+	static constexpr Property flag ( std::wstring_view English, std::wstring_view Russian ) {
+		return { English, Russian, readFlag<Field>, writeFlag<Field, Changed> };
+	}
+
+	template <auto Field, bool ( *Valid ) ( std::wstring_view ) = nullptr>
+	static constexpr Property text ( std::wstring_view English, std::wstring_view Russian ) {
+		return { English, Russian, readText<Field>, writeText<Field, Valid> };
+	}
+
+	// Component methods go after the ones every component has
+	template <typename... Entries>
+	static constexpr auto table ( const Entries&... Items ) {
+		return registry::Table<Method, 11 + sizeof... ( Entries )> ( std::array<Method, 11 + sizeof... ( Entries )> {
+				function<&Extender::version> ( L"Version", L"Версия", 0 ),
+				function<&Extender::getLastError> ( L"Problem", L"Проблема", 0 ),
+				function<&Extender::isError> ( L"Error", L"Ошибка", 0 ),
+				function<&Extender::avoided> ( L"AllocationsAvoided", L"ИзбежаноВыделений", 0 ),
+				function<&Extender::getStats> ( L"Stats", L"Статистика", 0 ),
+				procedure<&Extender::resetStats> ( L"ResetStats", L"СброситьСтатистику", 0 ),
+				procedure<&Extender::startTrace> ( L"StartTrace", L"НачатьТрассировку", 0 ),
+				function<&Extender::stopTrace> ( L"StopTrace", L"ЗавершитьТрассировку", 0 ),
+				function<&Extender::cancel> ( L"CancelAsync", L"ОтменитьАсинх", 1 ),
+				function<&Extender::getEventStats> ( L"EventStats", L"СтатистикаСобытий", 0 ),
+				function<&Extender::getMemoryStats> ( L"MemoryStats", L"СтатистикаПамяти", 0 ),
+				Items...
+		} );
+	}
+
+	// Component properties go after the ones every component has
+	template <typename... Entries>
+	static constexpr auto fields ( const Entries&... Items ) {
+		return registry::Table<Property, 4 + sizeof... ( Entries )> ( std::array<Property, 4 + sizeof... ( Entries )> {
+				number<&Extender::YellowBuffer, 1, 1000000, &Extender::applyBufferDepth> ( L"EventBufferDepth",
+																						   L"ГлубинаБуфераСобытий" ),
+				number<&Extender::eventLimit, 1, 1000000> ( L"EventLimit", L"ЛимитСобытий" ),
+				number<&Extender::eventLatency, 0, 1000> ( L"EventLatency", L"ЗадержкаСобытий" ),
+				flag<&Extender::eventCoalescing> ( L"EventCoalescing", L"СклеиватьСобытия" ),
+				Items...
+		} );
+	}
+
+	static Properties listProperties ();
 
 	WCHAR_T* ExtensionID;
-	const long YellowBuffer { 32758 };
-	propertiesList properties;
-	methodsList methods;
+	std::atomic<long> YellowBuffer { 32758 };
+	Methods methods;
+	Properties properties;
 	IAddInDefBase* baseConnector;
 	imemorymanager* memoryManager;
+	// Where threads of the component account their allocations, outside of method calls
+	Accounting::Counters* Background;
 
 	[[maybe_unused]] static long findName ( const wchar_t* Names[], const wchar_t* Name, uint32_t Size );
 	void addError ( uint32_t Code, const wchar_t* Descriptor, long Id ) const;
-	const WCHAR_T*
-	getName ( std::map<long, std::wstring>& SetEn, std::map<long, std::wstring>& SetRu, long Index, long Lang ) const;
-	static long
-	getIndex ( std::map<std::wstring, int>& SetEn, std::map<std::wstring, int>& SetRu, const wchar_t* Name );
-	void returnString ( tVariant* Result, const std::wstring& String ) const;
+	const WCHAR_T* getName ( std::wstring_view English, std::wstring_view Russian, long Lang ) const;
+	// Text results are best built in WCHAR_T units, Text and the JSON writer below do that
+	using Text = std::pmr::basic_string<WCHAR_T>;
+
+	void returnString ( tVariant* Result, Chars::View String ) const;
+#ifdef __linux__
+	void returnString ( tVariant* Result, std::wstring_view String ) const;
+#endif
+	void returnBlob ( tVariant* Result, std::string_view Data ) const;
+
+	// Structured results go out as JSON text, or as a CBOR or MessagePack blob, Build gets either writer
+	template <typename Build>
+	void returnStructure ( tVariant* Result, JSON::Encoding Format, const Build& Write ) const {
+		if ( Format == JSON::Encoding::Text ) {
+			JSON::Writer<WCHAR_T> json ( scratch () );
+			Write ( json );
+			returnString ( Result, json.Text () );
+		} else {
+			JSON::Binary data ( Format, scratch () );
+			Write ( data );
+			returnBlob ( Result, data.Data () );
+		}
+	}
 	static void returnBool ( tVariant* Result, bool Value );
+
+	// Memory for buffers that are dropped by the end of the current call
+	static std::pmr::memory_resource* scratch () {
+		return &Arena::Local ();
+	}
 	static double getNumber ( tVariant* Params );
+	// Where results are allocated, calls on the pool take them from the heap instead of 1C
+	[[nodiscard]] imemorymanager* memory () const;
+	// Calls still waiting are dropped, running ones are waited for
+	void drain ();
 private:
 	static constexpr WCHAR_T ErrorSignature[] = { '#', '#', '#', 'E', '#', '#', '#', '\0' };
+	static constexpr WCHAR_T AsyncSignature[] = { '#', '#', '#', 'A', '#', '#', '#', '\0' };
 	std::wstring LastError;
+	Statistics Stats;
+	// Accounting tags of the table methods, by position
+	std::vector<Accounting::Counters*> Allocations;
+	Dispatcher Events;
+
+	// MethodAsync calls: copies of the arguments and a state that decides between the pool and CancelAsync
+	struct Job;
+	// Positions of concurrent methods, their companions are numbered after the table
+	std::vector<long> Companions;
+	std::mutex JobsLock;
+	std::condition_variable JobsDone;
+	std::unordered_map<uint64_t, std::shared_ptr<Job>> Jobs;
+	uint64_t LastJob { 0 };
+
+	long base ( long Method ) const;
+	bool submit ( long Method, tVariant* Params, long Count, tVariant* Result );
+	void complete ( Job& Task );
+	std::wstring& error ();
 
-	void version ( tVariant* Result );
-	void isError ( tVariant* Result );
-	void getLastError ( tVariant* Result );
+	template <typename Type>
+	struct Owner;
+
+	template <typename Unit>
+	bool copy ( std::basic_string_view<Unit> Source, WCHAR_T** Destination ) const;
+	template <typename Unit>
+	void returnUnits ( tVariant* Result, std::basic_string_view<Unit> String ) const;
+
+	template <typename Value, typename Class>
+	struct Owner<Value Class::*> {
+		using Type = Class;
+	};
+
+	template <typename Result, typename Class, typename... Arguments>
+	struct Owner<Result ( Class::* ) ( Arguments... )> {
+		using Type = Class;
+	};
+
+	template <typename Result, typename Class, typename... Arguments>
+	struct Owner<Result ( Class::* ) ( Arguments... ) const> {
+		using Type = const Class;
+	};
+
+	template <auto Handler>
+	static bool call ( Extender& Self, tVariant* Params, tVariant* Result ) {
+		if constexpr ( std::is_member_function_pointer_v<decltype ( Handler )> ) {
+			auto& self = static_cast<typename Owner<decltype ( Handler )>::Type&> ( Self );
+			return run ( [ & ] ( auto... Arguments ) -> decltype ( ( self.*Handler ) ( Arguments... ) ) {
+				return ( self.*Handler ) ( Arguments... );
+			}, Params, Result );
+		} else {
+			return run ( Handler, Params, Result );
+		}
+	}
+
+	template <typename Call>
+	static bool run ( const Call& Handler, tVariant* Params, tVariant* Result ) {
+		if constexpr ( std::is_invocable_v<Call, tVariant*, tVariant*> ) {
+			return finish ( Handler, Params, Result );
+		} else if constexpr ( std::is_invocable_v<Call, tVariant*> ) {
+			return finish ( Handler, Params );
+		} else {
+			return finish ( Handler );
+		}
+	}
+
+	template <typename Call, typename... Arguments>
+	static bool finish ( const Call& Handler, Arguments... Values ) {
+		if constexpr ( std::is_void_v<std::invoke_result_t<Call, Arguments...>> ) {
+			Handler ( Values... );
+			return true;
+		} else {
+			return Handler ( Values... );
+		}
+	}
+
+	void version ( tVariant* Params, tVariant* Result );
+	void isError ( tVariant* Params, tVariant* Result );
+	void getLastError ( tVariant* Params, tVariant* Result );
+	static void avoided ( tVariant* Params, tVariant* Result );
+	void getStats ( tVariant* Params, tVariant* Result );
+	void resetStats ();
+	static void startTrace ();
+	void stopTrace ( tVariant* Params, tVariant* Result );
+	bool cancel ( tVariant* Params, tVariant* Result );
+	void getEventStats ( tVariant* Params, tVariant* Result );
+	void getMemoryStats ( tVariant* Params, tVariant* Result );
+
+	template <auto Field>
+	static auto& reach ( Extender& Self ) {
+		auto& self = static_cast<typename Owner<decltype ( Field )>::Type&> ( Self );
+		if constexpr ( std::is_member_function_pointer_v<decltype ( Field )> ) {
+			return ( self.*Field ) ();
+		} else {
+			return self.*Field;
+		}
+	}
+
+	template <auto Changed>
+	static void changed ( Extender& Self ) {
+		if constexpr ( !std::is_null_pointer_v<decltype ( Changed )> ) {
+			( static_cast<typename Owner<decltype ( Changed )>::Type&> ( Self ).*Changed ) ();
+		}
+	}
+
+	template <auto Field>
+	static bool readNumber ( Extender& Self, tVariant* Value ) {
+		Value->vt = VTYPE_I4;
+		Value->lVal = static_cast<int32_t> ( reach<Field> ( Self ).load () );
+		return true;
+	}
+
+	template <auto Field, long Minimum, long Maximum, auto Changed>
+	static bool writeNumber ( Extender& Self, tVariant* Value ) {
+		auto number = getNumber ( Value );
+		if ( !isNumber ( Value ) || number < Minimum || number > Maximum || number != static_cast<long> ( number ) ) {
+			Self.SetError ( "The value must be a whole number from " + std::to_string ( Minimum ) + " to "
+							+ std::to_string ( Maximum ) );
+			return false;
+		}
+		reach<Field> ( Self ) = static_cast<long> ( number );
+		changed<Changed> ( Self );
+		return true;
+	}
+
+	template <auto Field>
+	static bool readFlag ( Extender& Self, tVariant* Value ) {
+		returnBool ( Value, reach<Field> ( Self ).load () );
+		return true;
+	}
+
+	template <auto Field, auto Changed>
+	static bool writeFlag ( Extender& Self, tVariant* Value ) {
+		if ( Value->vt != VTYPE_BOOL ) {
+			Self.SetError ( "The value must be a boolean" );
+			return false;
+		}
+		reach<Field> ( Self ) = Value->bVal;
+		changed<Changed> ( Self );
+		return true;
+	}
+
+	template <auto Field>
+	static bool readText ( Extender& Self, tVariant* Value ) {
+		Self.returnString ( Value, std::wstring_view ( reach<Field> ( Self ) ) );
+		return true;
+	}
+
+	template <auto Field, bool ( *Valid ) ( std::wstring_view )>
+	static bool writeText ( Extender& Self, tVariant* Value ) {
+		if ( Value->vt != VTYPE_PWSTR ) {
+			Self.SetError ( "The value must be a string" );
+			return false;
+		}
+		std::wstring buffer;
+		auto text = Chars::Widen ( Chars::ToView ( Value ), buffer );
+		if ( Valid && !Valid ( text ) ) {
+			Self.SetError ( "The value is not valid for this property" );
+			return false;
+		}
+		reach<Field> ( Self ) = text;
+		return true;
+	}
+
+	static bool isNumber ( const tVariant* Value );
+	void applyBufferDepth ();
+
+	std::atomic<long>& eventLimit () {
+		return Events.Tune ().Limit;
+	}
+
+	std::atomic<long>& eventLatency () {
+		return Events.Tune ().Latency;
+	}
+
+	std::atomic<bool>& eventCoalescing () {
+		return Events.Tune ().Coalescing;
+	}
 };
 #endif
\ No newline at end of file
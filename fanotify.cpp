@@ -0,0 +1,153 @@
+#ifdef __linux__
+#include "fanotify.h"
+#include <cstring>
+#include <sys/fanotify.h>
+#include <unistd.h>
+#include <utility>
+
+namespace fs = std::filesystem;
+
+namespace Inotify {
+	namespace {
+		constexpr uint64_t Mask { FAN_CREATE | FAN_DELETE | FAN_MODIFY | FAN_MOVED_FROM | FAN_MOVED_TO | FAN_ONDIR };
+		// The kernel merges events on the same entry into one mask, while the observers take one action at a time
+		constexpr uint32_t Order[] { FAN_CREATE, FAN_MOVED_TO, FAN_MODIFY, FAN_MOVED_FROM, FAN_DELETE };
+
+		// Whether open_by_handle_at is allowed, the mark alone doesn't tell
+		bool openable ( int Mount, const fs::path& Root ) {
+			alignas ( file_handle ) unsigned char buffer[ sizeof ( file_handle ) + MAX_HANDLE_SZ ];
+			auto handle = reinterpret_cast<file_handle*> ( buffer );
+			handle->handle_bytes = MAX_HANDLE_SZ;
+			int mount;
+			if ( name_to_handle_at ( AT_FDCWD, Root.c_str (), handle, &mount, 0 ) == -1 ) {
+				return false;
+			}
+			auto descriptor = open_by_handle_at ( Mount, handle, O_PATH | O_CLOEXEC );
+			if ( descriptor == -1 ) {
+				return false;
+			}
+			close ( descriptor );
+			return true;
+		}
+	}
+
+	Fanotify::Fanotify ( int Notify, int Mount, fs::path Root )
+			: NotifyDescriptor ( Notify ), MountDescriptor ( Mount ), Root ( std::move ( Root ) ) {}
+
+	Fanotify::~Fanotify () {
+		close ( NotifyDescriptor );
+		close ( MountDescriptor );
+	}
+
+	std::unique_ptr<Fanotify> Fanotify::Open ( const fs::path& Root ) {
+		std::error_code error;
+		auto root = fs::canonical ( Root, error );
+		if ( error ) {
+			return nullptr;
+		}
+		auto notify = fanotify_init ( FAN_CLASS_NOTIF | FAN_REPORT_DFID_NAME | FAN_NONBLOCK | FAN_CLOEXEC,
+									  O_RDONLY | O_CLOEXEC );
+		if ( notify == -1 ) {
+			return nullptr;
+		}
+		auto mount = open ( root.c_str (), O_RDONLY | O_DIRECTORY | O_CLOEXEC );
+		if ( mount == -1 ) {
+			close ( notify );
+			return nullptr;
+		}
+		if ( !openable ( mount, root )
+			 || fanotify_mark ( notify, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, Mask, AT_FDCWD, root.c_str () ) == -1 ) {
+			close ( mount );
+			close ( notify );
+			return nullptr;
+		}
+		return std::unique_ptr<Fanotify> ( new Fanotify ( notify, mount, std::move ( root ) ) );
+	}
+
+	int Fanotify::Descriptor () const {
+		return NotifyDescriptor;
+	}
+
+	void Fanotify::Decode ( const uint8_t* Buffer, ssize_t Size, std::vector<SystemEvent>& Events ) {
+		auto length = Size;
+		auto event = reinterpret_cast<const fanotify_event_metadata*> ( Buffer );
+		for ( ; FAN_EVENT_OK ( event, length ); event = FAN_EVENT_NEXT ( event, length ) ) {
+			if ( event->mask & FAN_Q_OVERFLOW ) {
+				Events.emplace_back ( IN_Q_OVERFLOW, fs::path (), false );
+				continue;
+			}
+			if ( event->metadata_len + sizeof ( fanotify_event_info_fid ) > event->event_len ) {
+				continue;
+			}
+			auto info = reinterpret_cast<const fanotify_event_info_fid*> (
+					reinterpret_cast<const uint8_t*> ( event ) + event->metadata_len );
+			auto type = info->hdr.info_type;
+			if ( type != FAN_EVENT_INFO_TYPE_DFID_NAME && type != FAN_EVENT_INFO_TYPE_DFID ) {
+				continue;
+			}
+			auto handle = reinterpret_cast<file_handle*> ( const_cast<unsigned char*> ( info->handle ) );
+			auto folder = resolve ( handle );
+			if ( !folder ) {
+				continue;
+			}
+			auto path = std::move ( *folder );
+			if ( type == FAN_EVENT_INFO_TYPE_DFID_NAME ) {
+				auto name = reinterpret_cast<const char*> ( handle->f_handle + handle->handle_bytes );
+				if ( std::strcmp ( name, "." ) != 0 ) {
+					path /= name;
+				}
+			}
+			if ( !inside ( path ) ) {
+				continue;
+			}
+			auto directory = ( event->mask & FAN_ONDIR ) != 0;
+			if ( directory && ( event->mask & ( FAN_DELETE | FAN_MOVED_FROM ) ) ) {
+				Folders.clear ();
+			}
+			for ( auto action : Order ) {
+				if ( !( event->mask & action ) ) {
+					continue;
+				}
+				// inotify tells about the watched folder itself this way
+				if ( path == Root && action == FAN_DELETE ) {
+					action = IN_DELETE_SELF;
+				} else if ( path == Root && action == FAN_MOVED_FROM ) {
+					action = IN_MOVE_SELF;
+				}
+				Events.emplace_back ( action | ( directory ? IN_ISDIR : 0 ), path, directory );
+			}
+		}
+	}
+
+	std::optional<fs::path> Fanotify::resolve ( file_handle* Handle ) {
+		std::string key ( reinterpret_cast<const char*> ( Handle ), sizeof ( file_handle ) + Handle->handle_bytes );
+		if ( auto known = Folders.find ( key ); known != Folders.end () ) {
+			return known->second;
+		}
+		auto descriptor = open_by_handle_at ( MountDescriptor, Handle, O_PATH | O_CLOEXEC );
+		if ( descriptor == -1 ) {
+			return std::nullopt;
+		}
+		std::error_code error;
+		auto path = fs::read_symlink ( "/proc/self/fd/" + std::to_string ( descriptor ), error );
+		close ( descriptor );
+		if ( error ) {
+			return std::nullopt;
+		}
+		if ( Folders.size () >= FoldersLimit ) {
+			Folders.clear ();
+		}
+		Folders.emplace ( std::move ( key ), path );
+		return path;
+	}
+
+	bool Fanotify::inside ( const fs::path& Path ) const {
+		auto& path = Path.native ();
+		auto& root = Root.native ();
+		if ( path.compare ( 0, root.size (), root ) != 0 ) {
+			return false;
+		}
+		return path.size () == root.size () || root.back () == '/' || path[ root.size () ] == '/';
+	}
+}
+#endif
@@ -0,0 +1,42 @@
+#ifndef __fanotify_h__
+#define __fanotify_h__
+#ifdef __linux__
+#include <cstdint>
+#include <filesystem>
+#include <fcntl.h>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "inotify.h"
+
+namespace Inotify {
+	// A whole tree behind one filesystem mark instead of an inotify watch per folder. Events carry the handle
+	// of the folder and the name in it, folders are found through open_by_handle_at and kept until some folder
+	// is moved or removed. The mark needs CAP_SYS_ADMIN and the handles CAP_DAC_READ_SEARCH
+	class Fanotify {
+	public:
+		// Nothing when the kernel or the privileges don't allow it, inotify is used then
+		static std::unique_ptr<Fanotify> Open ( const std::filesystem::path& Root );
+		~Fanotify ();
+		Fanotify ( const Fanotify& ) = delete;
+		Fanotify& operator= ( const Fanotify& ) = delete;
+		int Descriptor () const;
+		// Events of one read under the root, in the masks inotify would give
+		void Decode ( const uint8_t* Buffer, ssize_t Size, std::vector<SystemEvent>& Events );
+	private:
+		// Resolved folders kept at most, the mark covers the whole filesystem so it isn't bounded by the tree
+		static constexpr size_t FoldersLimit { 4096 };
+		const int NotifyDescriptor;
+		const int MountDescriptor;
+		const std::filesystem::path Root;
+		std::unordered_map<std::string, std::filesystem::path> Folders;
+
+		Fanotify ( int Notify, int Mount, std::filesystem::path Root );
+		std::optional<std::filesystem::path> resolve ( file_handle* Handle );
+		bool inside ( const std::filesystem::path& Path ) const;
+	};
+}
+#endif
+#endif
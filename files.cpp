@@ -1,9 +1,19 @@
 #include "files.h"
 #include "transform.h"
+#include <algorithm>
 #include <cstdint>
 #include <fstream>
 #include <stdexcept>
+#include <system_error>
 #include <xxhash.h>
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#elif _WIN32
+#include <windows.h>
+#endif
 
 namespace files {
 std::string toString ( const std::string& file ) {
@@ -22,4 +32,150 @@ uint64_t toHash ( const std::string& file ) {
 	const auto string = strings::trim ( toString ( file ) );
 	return XXH3_64bits ( string.data (), string.size () );
 }
+
+bool matches ( std::string_view name, std::string_view mask ) {
+	size_t i = 0, j = 0;
+	auto star = std::string_view::npos;
+	size_t resume = 0;
+	while ( i < name.size () ) {
+		if ( j < mask.size () && ( mask [ j ] == '?' || mask [ j ] == name [ i ] ) ) {
+			++i;
+			++j;
+		} else if ( j < mask.size () && mask [ j ] == '*' ) {
+			star = j++;
+			resume = i;
+		} else if ( star != std::string_view::npos ) {
+			j = star + 1;
+			i = ++resume;
+		} else {
+			return false;
+		}
+	}
+	while ( j < mask.size () && mask [ j ] == '*' ) {
+		++j;
+	}
+	return j == mask.size ();
+}
+
+std::vector<std::filesystem::path> expand ( const std::filesystem::path& mask ) {
+	namespace fs = std::filesystem;
+	std::vector<fs::path> result;
+	std::error_code error;
+	auto name = mask.filename ().u8string ();
+	fs::path folder;
+	if ( name.find_first_of ( "*?" ) != std::string::npos ) {
+		folder = mask.parent_path ();
+	} else if ( fs::is_directory ( mask, error ) ) {
+		folder = mask;
+		name = "*";
+	} else {
+		result.push_back ( mask );
+		return result;
+	}
+	// A bare mask as *.log means the current folder, the files are given as relative as the mask was
+	auto relative = folder.empty ();
+	fs::directory_iterator it ( relative ? fs::path ( "." ) : folder, error ), end;
+	for ( ; !error && it != end; it.increment ( error ) ) {
+		std::error_code type;
+		if ( it->is_regular_file ( type ) && matches ( it->path ().filename ().u8string (), name ) ) {
+			result.push_back ( relative ? it->path ().filename () : it->path () );
+		}
+	}
+	if ( error ) {
+		throw std::system_error ( error, "failed to list: " + ( relative ? fs::path ( "." ) : folder ).u8string () );
+	}
+	std::sort ( result.begin (), result.end () );
+	return result;
+}
+
+#ifdef __linux__
+Mapping::Mapping ( const std::filesystem::path& file ) {
+	auto descriptor = open ( file.c_str (), O_RDONLY | O_CLOEXEC );
+	if ( descriptor == -1 ) {
+		throw std::system_error ( errno, std::generic_category (), "failed to open: " + file.string () );
+	}
+	struct stat info {};
+	if ( fstat ( descriptor, &info ) == -1 ) {
+		auto code = errno;
+		close ( descriptor );
+		throw std::system_error ( code, std::generic_category (), "failed to stat: " + file.string () );
+	}
+	length = info.st_size;
+	if ( length ) {
+		auto address = mmap ( nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0 );
+		if ( address == MAP_FAILED ) {
+			auto code = errno;
+			close ( descriptor );
+			throw std::system_error ( code, std::generic_category (), "failed to map: " + file.string () );
+		}
+		madvise ( address, length, MADV_SEQUENTIAL );
+		begin = static_cast<const char*> ( address );
+	}
+	close ( descriptor );
+}
+
+Mapping::~Mapping () {
+	if ( begin ) {
+		munmap ( const_cast<char*> ( begin ), length );
+	}
+}
+
+void Mapping::release ( size_t offset, size_t size ) const {
+	static const auto page = static_cast<size_t> ( sysconf ( _SC_PAGESIZE ) );
+	auto from = offset / page * page;
+	if ( !begin || !size ) {
+		return;
+	}
+	madvise ( const_cast<char*> ( begin ) + from, offset + size - from, MADV_DONTNEED );
+}
+#elif _WIN32
+Mapping::Mapping ( const std::filesystem::path& file ) {
+	this->file = CreateFileW ( file.c_str (), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+							   nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+	if ( this->file == INVALID_HANDLE_VALUE ) {
+		this->file = nullptr;
+		throw std::system_error ( GetLastError (), std::system_category (), "failed to open: " + file.string () );
+	}
+	LARGE_INTEGER size;
+	if ( !GetFileSizeEx ( this->file, &size ) ) {
+		auto code = GetLastError ();
+		CloseHandle ( this->file );
+		throw std::system_error ( code, std::system_category (), "failed to stat: " + file.string () );
+	}
+	length = static_cast<size_t> ( size.QuadPart );
+	if ( !length ) {
+		return;
+	}
+	view = CreateFileMappingW ( this->file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+	if ( view ) {
+		begin = static_cast<const char*> ( MapViewOfFile ( view, FILE_MAP_READ, 0, 0, 0 ) );
+	}
+	if ( !begin ) {
+		auto code = GetLastError ();
+		if ( view ) {
+			CloseHandle ( view );
+		}
+		CloseHandle ( this->file );
+		throw std::system_error ( code, std::system_category (), "failed to map: " + file.string () );
+	}
+}
+
+Mapping::~Mapping () {
+	if ( begin ) {
+		UnmapViewOfFile ( begin );
+	}
+	if ( view ) {
+		CloseHandle ( view );
+	}
+	if ( file ) {
+		CloseHandle ( file );
+	}
+}
+
+void Mapping::release ( size_t offset, size_t size ) const {
+	if ( begin && size ) {
+		VirtualUnlock ( const_cast<char*> ( begin ) + offset, size );
+	}
+}
+#endif
 }
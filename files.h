@@ -1,8 +1,41 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
+#include <filesystem>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace files {
 std::string toString ( const std::string& file );
 uint64_t toHash ( const std::string& file );
+bool matches ( std::string_view name, std::string_view mask );
+std::vector<std::filesystem::path> expand ( const std::filesystem::path& mask );
+
+// Read-only memory mapping of a whole file
+class Mapping {
+public:
+	explicit Mapping ( const std::filesystem::path& file );
+	~Mapping ();
+	Mapping ( const Mapping& ) = delete;
+	Mapping& operator= ( const Mapping& ) = delete;
+
+	[[nodiscard]] const char* data () const {
+		return begin;
+	}
+
+	[[nodiscard]] size_t size () const {
+		return length;
+	}
+
+	// Lets the system drop pages which are already processed
+	void release ( size_t offset, size_t size ) const;
+private:
+	const char* begin { nullptr };
+	size_t length { 0 };
+#ifdef _WIN32
+	void* file { nullptr };
+	void* view { nullptr };
+#endif
+};
 }
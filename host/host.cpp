@@ -0,0 +1,305 @@
+#include "host.h"
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <stdexcept>
+#include "../unicode.h"
+
+namespace host {
+namespace {
+	std::string utf8 ( const WCHAR_T* Units ) {
+		if ( !Units ) {
+			return {};
+		}
+		size_t size { 0 };
+		while ( Units[ size ] ) {
+			++size;
+		}
+		return unicode::utf16To8 ( std::basic_string_view<WCHAR_T> ( Units, size ) );
+	}
+}
+
+bool Memory::AllocMemory ( void** Pointer, unsigned long Bytes ) {
+	*Pointer = std::malloc ( Bytes );
+	std::lock_guard<std::mutex> guard ( Lock );
+	Allocations += *Pointer != nullptr;
+	return *Pointer != nullptr;
+}
+
+void Memory::FreeMemory ( void** Pointer ) {
+	if ( !*Pointer ) {
+		return;
+	}
+	std::free ( *Pointer );
+	*Pointer = nullptr;
+	std::lock_guard<std::mutex> guard ( Lock );
+	++Frees;
+}
+
+uint64_t Memory::Allocated () const {
+	std::lock_guard<std::mutex> guard ( Lock );
+	return Allocations;
+}
+
+uint64_t Memory::Freed () const {
+	std::lock_guard<std::mutex> guard ( Lock );
+	return Frees;
+}
+
+bool Connection::AddError ( unsigned short Code, const WCHAR_T* Source, const WCHAR_T* Description, long ) {
+	std::lock_guard<std::mutex> guard ( Lock );
+	Raised.push_back ( { Code, utf8 ( Source ), utf8 ( Description ) } );
+	return true;
+}
+
+bool Connection::Read ( WCHAR_T*, tVariant*, long*, WCHAR_T** ) {
+	return false;
+}
+
+bool Connection::Write ( WCHAR_T*, tVariant* ) {
+	return false;
+}
+
+bool Connection::RegisterProfileAs ( WCHAR_T* ) {
+	return true;
+}
+
+bool Connection::SetEventBufferDepth ( long Depth ) {
+	std::lock_guard<std::mutex> guard ( Lock );
+	this->Depth = Depth;
+	return true;
+}
+
+long Connection::GetEventBufferDepth () {
+	std::lock_guard<std::mutex> guard ( Lock );
+	return Depth;
+}
+
+bool Connection::ExternalEvent ( const WCHAR_T* Source, const WCHAR_T* Message, const WCHAR_T* Data ) {
+	{
+		std::lock_guard<std::mutex> guard ( Lock );
+		Received.push_back ( { utf8 ( Source ), utf8 ( Message ), utf8 ( Data ) } );
+	}
+	Arrived.notify_all ();
+	return true;
+}
+
+void Connection::CleanEventBuffer () {
+	std::lock_guard<std::mutex> guard ( Lock );
+	Received.clear ();
+}
+
+bool Connection::SetStatusLine ( WCHAR_T* ) {
+	return true;
+}
+
+void Connection::ResetStatusLine () {}
+
+IInterface* Connection::GetInterface ( Interfaces ) {
+	return nullptr;
+}
+
+bool Connection::Wait ( size_t Count, std::chrono::milliseconds Timeout ) {
+	std::unique_lock<std::mutex> lock ( Lock );
+	return Arrived.wait_for ( lock, Timeout, [ & ] {
+		return Received.size () >= Count;
+	} );
+}
+
+std::vector<Connection::Event> Connection::Events () {
+	std::lock_guard<std::mutex> guard ( Lock );
+	return Received;
+}
+
+std::vector<Connection::Error> Connection::Errors () {
+	std::lock_guard<std::mutex> guard ( Lock );
+	return Raised;
+}
+
+Value::Value () {
+	Data.vt = VTYPE_EMPTY;
+}
+
+Value Value::String ( std::string_view Utf8 ) {
+	Value result;
+	result.Units = unicode::utf8To16<WCHAR_T> ( Utf8 );
+	result.Data.vt = VTYPE_PWSTR;
+	result.bind ();
+	return result;
+}
+
+Value Value::Number ( double Number ) {
+	Value result;
+	result.Data.vt = VTYPE_R8;
+	result.Data.dblVal = Number;
+	return result;
+}
+
+Value Value::Integer ( int32_t Number ) {
+	Value result;
+	result.Data.vt = VTYPE_I4;
+	result.Data.lVal = Number;
+	return result;
+}
+
+Value Value::Bool ( bool Flag ) {
+	Value result;
+	result.Data.vt = VTYPE_BOOL;
+	result.Data.bVal = Flag;
+	return result;
+}
+
+Value Value::Blob ( std::string Bytes ) {
+	Value result;
+	result.Bytes = std::move ( Bytes );
+	result.Data.vt = VTYPE_BLOB;
+	result.bind ();
+	return result;
+}
+
+Value::Value ( const Value& Other ) : Data ( Other.Data ), Units ( Other.Units ), Bytes ( Other.Bytes ) {
+	bind ();
+}
+
+Value& Value::operator= ( const Value& Other ) {
+	Data = Other.Data;
+	Units = Other.Units;
+	Bytes = Other.Bytes;
+	bind ();
+	return *this;
+}
+
+// Pointers into the strings this value keeps, set again after every copy
+void Value::bind () {
+	if ( Data.vt == VTYPE_PWSTR ) {
+		Data.pwstrVal = Units.data ();
+		Data.wstrLen = static_cast<uint32_t> ( Units.size () );
+	} else if ( Data.vt == VTYPE_BLOB ) {
+		Data.pstrVal = Bytes.data ();
+		Data.strLen = static_cast<uint32_t> ( Bytes.size () );
+	}
+}
+
+Component::Component ( IComponentBase* Object, DestroyObjectPtr Destroy, Connection& Host, Memory& Heap )
+		: Object ( Object ), Destroy ( Destroy ), Heap ( Heap ) {
+	Object->setMemManager ( &Heap );
+	Object->Init ( static_cast<IAddInDefBase*> ( &Host ) );
+}
+
+Component::~Component () {
+	Object->Done ();
+	Destroy ( &Object );
+}
+
+long Component::Find ( std::string_view Name ) const {
+	auto name = unicode::utf8To16<WCHAR_T> ( Name );
+	return Object->FindMethod ( name.c_str () );
+}
+
+long Component::Methods () const {
+	return Object->GetNMethods ();
+}
+
+std::string Component::Name ( long Method, long Lang ) const {
+	auto name = const_cast<WCHAR_T*> ( Object->GetMethodName ( Method, Lang ) );
+	auto result = utf8 ( name );
+	Heap.FreeMemory ( reinterpret_cast<void**> ( &name ) );
+	return result;
+}
+
+Result Component::Call ( long Method, const std::vector<Value>& Arguments, bool Function ) {
+	Result result { false, VTYPE_EMPTY, {}, 0 };
+	auto count = Object->GetNParams ( Method );
+	if ( Method < 0 || static_cast<long> ( Arguments.size () ) > count ) {
+		return result;
+	}
+	std::vector<tVariant> params ( count );
+	for ( long i = 0; i < count; ++i ) {
+		if ( i < static_cast<long> ( Arguments.size () ) ) {
+			params[ i ] = Arguments[ i ].Variant ();
+		} else if ( !Object->GetParamDefValue ( Method, i, &params[ i ] ) ) {
+			return result;
+		}
+	}
+	if ( !Function || !Object->HasRetVal ( Method ) ) {
+		result.Success = Object->CallAsProc ( Method, params.data (), count );
+		return result;
+	}
+	tVariant value {};
+	result.Success = Object->CallAsFunc ( Method, &value, params.data (), count );
+	result.Type = value.vt;
+	switch ( value.vt ) {
+		case VTYPE_PWSTR:
+			result.Text = unicode::utf16To8 ( std::basic_string_view<WCHAR_T> ( value.pwstrVal, value.wstrLen ) );
+			Heap.FreeMemory ( reinterpret_cast<void**> ( &value.pwstrVal ) );
+			break;
+		case VTYPE_BLOB:
+			result.Text.assign ( value.pstrVal, value.strLen );
+			Heap.FreeMemory ( reinterpret_cast<void**> ( &value.pstrVal ) );
+			break;
+		case VTYPE_BOOL:
+			result.Number = value.bVal;
+			result.Text = value.bVal ? "true" : "false";
+			break;
+		case VTYPE_I4:
+			result.Number = value.lVal;
+			result.Text = std::to_string ( value.lVal );
+			break;
+		case VTYPE_R8:
+			result.Number = value.dblVal;
+			result.Text = std::to_string ( value.dblVal );
+			break;
+		default:
+			break;
+	}
+	return result;
+}
+
+Result Component::Call ( std::string_view Name, const std::vector<Value>& Arguments, bool Function ) {
+	return Call ( Find ( Name ), Arguments, Function );
+}
+
+Module::Module ( const std::string& Path ) : Handle ( dlopen ( Path.c_str (), RTLD_NOW | RTLD_LOCAL ) ) {
+	if ( !Handle ) {
+		throw std::runtime_error ( dlerror () );
+	}
+	getClassObject = reinterpret_cast<GetClassObjectPtr> ( dlsym ( Handle, "GetClassObject" ) );
+	destroyObject = reinterpret_cast<DestroyObjectPtr> ( dlsym ( Handle, "DestroyObject" ) );
+	getClassNames = reinterpret_cast<GetClassNamesPtr> ( dlsym ( Handle, "GetClassNames" ) );
+	if ( !getClassObject || !destroyObject || !getClassNames ) {
+		dlclose ( Handle );
+		throw std::runtime_error ( Path + " is not a Native API component" );
+	}
+	if ( auto capabilities = reinterpret_cast<SetPlatformCapabilitiesPtr> ( dlsym ( Handle, "SetPlatformCapabilities" ) ) ) {
+		capabilities ( AppCapabilitiesLast );
+	}
+}
+
+Module::~Module () {
+	dlclose ( Handle );
+}
+
+std::vector<std::string> Module::Classes () const {
+	std::vector<std::string> result;
+	auto names = utf8 ( getClassNames () );
+	size_t start { 0 };
+	while ( start <= names.size () ) {
+		auto end = names.find ( '|', start );
+		if ( end == std::string::npos ) {
+			end = names.size ();
+		}
+		result.push_back ( names.substr ( start, end - start ) );
+		start = end + 1;
+	}
+	return result;
+}
+
+std::unique_ptr<Component> Module::Create ( std::string_view Class, Connection& Host, Memory& Heap ) const {
+	auto name = unicode::utf8To16<WCHAR_T> ( Class );
+	IComponentBase* object { nullptr };
+	if ( !getClassObject ( name.c_str (), &object ) || !object ) {
+		return nullptr;
+	}
+	return std::make_unique<Component> ( object, destroyObject, Host, Heap );
+}
+}
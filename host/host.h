@@ -0,0 +1,142 @@
+#ifndef __host_h__
+#define __host_h__
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../1c/addindefbase.h"
+#include "../1c/componentbase.h"
+#include "../1c/imemorymanager.h"
+
+// What 1C:Enterprise does around a component, enough to run one outside of it: the module is loaded
+// with dlopen, objects come from GetClassObject, calls go through FindMethod and CallAsFunc with
+// tVariant arguments, and whatever the component reports back is recorded
+namespace host {
+using Text = std::basic_string<WCHAR_T>;
+
+// Results and names the component allocates, counted so leaks show up
+class Memory : public imemorymanager {
+public:
+	bool ADDIN_API AllocMemory ( void** Pointer, unsigned long Bytes ) override;
+	void ADDIN_API FreeMemory ( void** Pointer ) override;
+	[[nodiscard]] uint64_t Allocated () const;
+	[[nodiscard]] uint64_t Freed () const;
+private:
+	mutable std::mutex Lock;
+	uint64_t Allocations { 0 };
+	uint64_t Frees { 0 };
+};
+
+// The 1C side of the connection, ExternalEvent comes from any thread
+class Connection : public IAddInDefBaseEx {
+public:
+	struct Event {
+		std::string Source;
+		std::string Message;
+		std::string Data;
+	};
+
+	struct Error {
+		unsigned short Code;
+		std::string Source;
+		std::string Description;
+	};
+
+	bool ADDIN_API AddError ( unsigned short Code, const WCHAR_T* Source, const WCHAR_T* Description,
+							  long Id ) override;
+	bool ADDIN_API Read ( WCHAR_T* Name, tVariant* Value, long* Error, WCHAR_T** Description ) override;
+	bool ADDIN_API Write ( WCHAR_T* Name, tVariant* Value ) override;
+	bool ADDIN_API RegisterProfileAs ( WCHAR_T* Name ) override;
+	bool ADDIN_API SetEventBufferDepth ( long Depth ) override;
+	long ADDIN_API GetEventBufferDepth () override;
+	bool ADDIN_API ExternalEvent ( const WCHAR_T* Source, const WCHAR_T* Message, const WCHAR_T* Data ) override;
+	void ADDIN_API CleanEventBuffer () override;
+	bool ADDIN_API SetStatusLine ( WCHAR_T* Line ) override;
+	void ADDIN_API ResetStatusLine () override;
+	IInterface* ADDIN_API GetInterface ( Interfaces Interface ) override;
+
+	// Waits until Count events came in total, false on timeout
+	bool Wait ( size_t Count, std::chrono::milliseconds Timeout );
+	std::vector<Event> Events ();
+	std::vector<Error> Errors ();
+private:
+	std::mutex Lock;
+	std::condition_variable Arrived;
+	std::vector<Event> Received;
+	std::vector<Error> Raised;
+	long Depth { 0 };
+};
+
+// An argument as 1C passes it, strings are kept by the value
+class Value {
+public:
+	Value ();
+	static Value String ( std::string_view Utf8 );
+	static Value Number ( double Number );
+	static Value Integer ( int32_t Number );
+	static Value Bool ( bool Flag );
+	static Value Blob ( std::string Bytes );
+
+	Value ( const Value& Other );
+	Value& operator= ( const Value& Other );
+	[[nodiscard]] const tVariant& Variant () const {
+		return Data;
+	}
+private:
+	tVariant Data {};
+	Text Units;
+	std::string Bytes;
+
+	void bind ();
+};
+
+// The value is freed by the time the result is seen, strings come as UTF-8 and blobs as they are
+struct Result {
+	bool Success;
+	TYPEVAR Type;
+	std::string Text;
+	double Number;
+};
+
+class Component {
+public:
+	Component ( IComponentBase* Object, DestroyObjectPtr Destroy, Connection& Host, Memory& Heap );
+	~Component ();
+	Component ( const Component& ) = delete;
+	Component& operator= ( const Component& ) = delete;
+
+	[[nodiscard]] long Find ( std::string_view Name ) const;
+	// Checks the count, fills the trailing optional ones with empty values and calls as 1C would
+	Result Call ( long Method, const std::vector<Value>& Arguments, bool Function = true );
+	Result Call ( std::string_view Name, const std::vector<Value>& Arguments, bool Function = true );
+	[[nodiscard]] std::string Name ( long Method, long Lang = 0 ) const;
+	[[nodiscard]] long Methods () const;
+private:
+	IComponentBase* Object;
+	DestroyObjectPtr Destroy;
+	Memory& Heap;
+};
+
+// A component module loaded like the platform does
+class Module {
+public:
+	explicit Module ( const std::string& Path );
+	~Module ();
+	Module ( const Module& ) = delete;
+	Module& operator= ( const Module& ) = delete;
+
+	[[nodiscard]] std::vector<std::string> Classes () const;
+	// Null when the module has no such class
+	std::unique_ptr<Component> Create ( std::string_view Class, Connection& Host, Memory& Heap ) const;
+private:
+	void* Handle;
+	GetClassObjectPtr getClassObject;
+	DestroyObjectPtr destroyObject;
+	GetClassNamesPtr getClassNames;
+};
+}
+#endif
@@ -0,0 +1,106 @@
+#include "host.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace {
+	void usage () {
+		std::cerr << "Usage: host [-n calls] [-e events] <module> <class> <method> [argument...]\n"
+					 "  -n calls   repeat the call and report the time per call\n"
+					 "  -e events  wait up to 5 seconds for that many external events\n"
+					 "Arguments: #42 is a number, !true or !false a boolean, @path the text of a file,\n"
+					 "anything else a string. Missing trailing arguments are passed as 1C does.\n";
+	}
+
+	host::Value argument ( const std::string& Text ) {
+		if ( Text.size () > 1 && Text[ 0 ] == '#' ) {
+			return host::Value::Number ( std::strtod ( Text.c_str () + 1, nullptr ) );
+		}
+		if ( Text == "!true" || Text == "!false" ) {
+			return host::Value::Bool ( Text == "!true" );
+		}
+		if ( Text.size () > 1 && Text[ 0 ] == '@' ) {
+			std::ifstream file ( Text.substr ( 1 ), std::ios::binary );
+			return host::Value::String ( std::string ( std::istreambuf_iterator<char> ( file ), {} ) );
+		}
+		return host::Value::String ( Text );
+	}
+}
+
+int main ( int argc, char** argv ) {
+	long calls { 1 };
+	size_t events { 0 };
+	int position { 1 };
+	for ( ; position + 1 < argc && argv[ position ][ 0 ] == '-'; position += 2 ) {
+		std::string option { argv[ position ] };
+		if ( option == "-n" ) {
+			calls = std::max ( 1l, std::atol ( argv[ position + 1 ] ) );
+		} else if ( option == "-e" ) {
+			events = std::strtoul ( argv[ position + 1 ], nullptr, 10 );
+		} else {
+			usage ();
+			return 2;
+		}
+	}
+	if ( argc - position < 3 ) {
+		usage ();
+		return 2;
+	}
+	try {
+		host::Memory memory;
+		host::Connection connection;
+		host::Module module ( argv[ position ] );
+		auto component = module.Create ( argv[ position + 1 ], connection, memory );
+		if ( !component ) {
+			std::cerr << "No class " << argv[ position + 1 ] << ", the module has:";
+			for ( auto& name : module.Classes () ) {
+				std::cerr << ' ' << name;
+			}
+			std::cerr << '\n';
+			return 2;
+		}
+		auto method = component->Find ( argv[ position + 2 ] );
+		if ( method < 0 ) {
+			std::cerr << "No method " << argv[ position + 2 ] << '\n';
+			return 2;
+		}
+		std::vector<host::Value> arguments;
+		for ( int i = position + 3; i < argc; ++i ) {
+			arguments.push_back ( argument ( argv[ i ] ) );
+		}
+		host::Result result {};
+		auto start = std::chrono::steady_clock::now ();
+		for ( long i = 0; i < calls; ++i ) {
+			result = component->Call ( method, arguments );
+		}
+		auto elapsed = std::chrono::duration<double, std::micro> ( std::chrono::steady_clock::now () - start );
+		if ( events && !connection.Wait ( events, std::chrono::seconds ( 5 ) ) ) {
+			std::cerr << "Timed out waiting for events\n";
+		}
+		std::cout << ( result.Success ? "Success" : "Failure" ) << '\n';
+		if ( result.Type != VTYPE_EMPTY ) {
+			std::cout << result.Text << '\n';
+		}
+		for ( auto& event : connection.Events () ) {
+			std::cout << "Event " << event.Source << ' ' << event.Message << ' ' << event.Data << '\n';
+		}
+		for ( auto& error : connection.Errors () ) {
+			std::cout << "Error " << error.Code << ' ' << error.Source << ' ' << error.Description << '\n';
+		}
+		if ( calls > 1 ) {
+			std::cout << calls << " calls, " << elapsed.count () / calls << " us per call\n";
+		}
+		component.reset ();
+		if ( memory.Allocated () != memory.Freed () ) {
+			std::cout << "Leaked " << memory.Allocated () - memory.Freed () << " of " << memory.Allocated ()
+					  << " allocations\n";
+		}
+		return result.Success ? 0 : 1;
+	} catch ( const std::exception& E ) {
+		std::cerr << E.what () << '\n';
+		return 2;
+	}
+}
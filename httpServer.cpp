@@ -1,5 +1,7 @@
 #include "httpServer.h"
 #include "json.h"
+#include "trace.h"
+#include "unicode.h"
 #include <X11/Xlib.h>
 #include <cerrno>
 #include <chrono>
@@ -9,24 +11,26 @@
 #include <optional>
 #include <system_error>
 #include <thread>
-#include <utf8.h>
 #ifdef _WIN32
 #include <winsock2.h>
 #include <ws2tcpip.h>
 #endif
 
-HTTPServer::HTTPServer () : Extender ( L"httpServer" ), waiting ( false ) {
+HTTPServer::HTTPServer () : Extender ( L"httpServer", listMethods (), listProperties () ), waiting ( false ) {
 	init ();
-	addProcedure ( L"Start", L"Старт", 2,
-								 [ & ] ( tVariant* Params ) { return start ( Params ); } );
-	addProcedure ( L"Stop", L"Стоп", 0, [ & ] ( tVariant* ) {
-		stop ();
-		return true;
-	} );
-	addProcedure ( L"Send", L"Послать", 1, [ & ] ( tVariant* Params ) {
-		send ( Params );
-		return true;
-	} );
+}
+
+Extender::Methods HTTPServer::listMethods () {
+	static constexpr auto list = table (
+			procedure<&HTTPServer::start> ( L"Start", L"Старт", 2 ),
+			procedure<&HTTPServer::stop> ( L"Stop", L"Стоп", 0 ),
+			procedure<&HTTPServer::send> ( L"Send", L"Послать", 1 ) );
+	return list;
+}
+
+Extender::Properties HTTPServer::listProperties () {
+	static constexpr auto list = fields ( number<&HTTPServer::Timeout, 1, 3600> ( L"Timeout", L"Таймаут" ) );
+	return list;
 }
 
 void HTTPServer::init () {
@@ -34,6 +38,9 @@ void HTTPServer::init () {
 	server.set_keep_alive_max_count ( 1 );
 	server.Post ( "/", [ this ] ( const httplib::Request& request,
 																httplib::Response& response ) {
+		Tracer::Label ( "HTTP worker" );
+		Tracer::Span span ( L"Request", "http" );
+		Accounting::Scope account ( Background );
 		{
 			std::lock_guard<std::mutex> lock ( router );
 			if ( waiting ) {
@@ -41,12 +48,11 @@ void HTTPServer::init () {
 			}
 			waiting = true;
 		}
-		auto body = utf8::utf8to16 ( request.body );
-		getBaseConnector ()->ExternalEvent ( getExtensionID (), u"",
-																				 body.c_str () );
+		auto body = unicode::utf8To16<char16_t> ( request.body );
+		Post ( {}, Chars::View ( reinterpret_cast<const WCHAR_T*> ( body.data () ), body.size () ) );
 		std::unique_lock<std::mutex> lock ( router );
 		const auto ready =
-				condition.wait_for ( lock, std::chrono::seconds ( 30 ),
+				condition.wait_for ( lock, std::chrono::seconds ( Timeout.load () ),
 														 [ & ] { return data.has_value (); } );
 		auto result = ready ? *data : "Tester is busy";
 		response.set_content ( result, "text/plain" );
@@ -101,7 +107,11 @@ std::optional<HTTPServer::BindError> HTTPServer::startServer ( std::string host,
 		}
 		return error;
 	}
-	worker = std::jthread ( [ this ] { server.listen_after_bind (); } );
+	worker = std::jthread ( [ this ] {
+		Tracer::Label ( "HTTP listener" );
+		Accounting::Scope account ( Background );
+		server.listen_after_bind ();
+	} );
 	server.wait_until_ready ();
 	if ( server.is_running () ) {
 		return std::nullopt;
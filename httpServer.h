@@ -8,6 +8,7 @@
 #undef None
 #endif
 #include <httplib.h>
+#include <atomic>
 #include <thread>
 #include <optional>
 
@@ -29,7 +30,11 @@ private:
 	std::optional<std::string> data;
 	std::condition_variable condition;
 	bool waiting;
+	// Seconds a request waits for Send before it gets the busy answer
+	std::atomic<long> Timeout { 30 };
 
+	static Methods listMethods ();
+	static Properties listProperties ();
 	void init ();
 	bool start ( tVariant* Params );
 	void send ( tVariant* Params );
@@ -1,5 +1,10 @@
 #ifdef __linux__
 #include "inotify.h"
+#include "fanotify.h"
+#include "walker.h"
+#include <algorithm>
+#include <climits>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -19,7 +24,7 @@ namespace Inotify {
 			: Mask ( Mask ), Path ( std::move ( Path ) ), Directory ( Directory ) {};
 
 	Inotify::Inotify ()
-			: EventMask ( IN_ALL_EVENTS ), IgnoreFolders ( std::vector<std::string> () ),
+			: EventMask ( 0 ), IgnoreFolders ( std::vector<std::string> () ), WholeTree ( false ),
 			  InotifyDescriptor ( 0 ), EventBuffer ( EventsLimit * ( EventSize + 16 ), 0 ),
 			  PipeReadIndex ( 0 ), PipeWriteIndex ( 1 ), Stopped ( false ) {
 		if ( pipe2 ( StopPipeDescriptor, O_NONBLOCK ) == -1 ) {
@@ -57,6 +62,7 @@ namespace Inotify {
 	}
 
 	Inotify::~Inotify () {
+		releaseTree ();
 		epoll_ctl ( EpollDescriptor, EPOLL_CTL_DEL, InotifyDescriptor, nullptr );
 		epoll_ctl ( EpollDescriptor, EPOLL_CTL_DEL, StopPipeDescriptor[ PipeReadIndex ], nullptr );
 		close ( InotifyDescriptor );
@@ -67,21 +73,49 @@ namespace Inotify {
 
 	void Inotify::Watch ( const std::filesystem::path& Path ) {
 		checkPath ( Path );
-		std::vector<std::filesystem::path> list;
-		list.push_back ( Path );
-		if ( fs::is_directory ( Path ) ) {
-			std::error_code ec;
-			fs::recursive_directory_iterator it ( Path, fs::directory_options::follow_directory_symlink, ec );
-			fs::recursive_directory_iterator end;
-			for ( ; it != end; it.increment ( ec ) ) {
-				fs::path currentPath = *it;
-				if ( fs::is_directory ( currentPath ) && !fs::is_symlink ( currentPath ) ) {
-					list.push_back ( currentPath );
-				}
+		releaseTree ();
+		if ( WholeTree && watchTree ( Path ) ) {
+			return;
+		}
+		if ( !fs::is_directory ( Path ) ) {
+			WatchPath ( Path );
+			return;
+		}
+		std::mutex lock;
+		Walker walker ( [ & ] ( const fs::path& Folder, bool ) {
+			if ( isIgnored ( Folder ) ) {
+				return false;
 			}
+			auto descriptor = addWatch ( Folder );
+			std::lock_guard<std::mutex> guard ( lock );
+			savePath ( descriptor, Folder );
+			return true;
+		}, false );
+		walker.Walk ( Path );
+	}
+
+	bool Inotify::watchTree ( const std::filesystem::path& Path ) {
+		if ( !fs::is_directory ( Path ) || isIgnored ( Path ) ) {
+			return false;
+		}
+		Tree = Fanotify::Open ( Path );
+		if ( !Tree ) {
+			return false;
 		}
-		for ( auto& entry : list ) {
-			WatchPath ( entry );
+		epoll_event event {};
+		event.events = EPOLLIN;
+		event.data.fd = Tree->Descriptor ();
+		if ( epoll_ctl ( EpollDescriptor, EPOLL_CTL_ADD, Tree->Descriptor (), &event ) == -1 ) {
+			Tree.reset ();
+			return false;
+		}
+		return true;
+	}
+
+	void Inotify::releaseTree () {
+		if ( Tree ) {
+			epoll_ctl ( EpollDescriptor, EPOLL_CTL_DEL, Tree->Descriptor (), nullptr );
+			Tree.reset ();
 		}
 	}
 
@@ -96,7 +130,12 @@ namespace Inotify {
 			return;
 		}
 		checkPath ( Path );
-		auto descriptor = inotify_add_watch ( InotifyDescriptor, Path.string ().c_str (), EventMask );
+		savePath ( addWatch ( Path ), Path );
+	}
+
+	int Inotify::addWatch ( const std::filesystem::path& Path ) const {
+		// Only what is subscribed to, so reading the tree while it is watched doesn't queue opens and closes
+		auto descriptor = inotify_add_watch ( InotifyDescriptor, Path.c_str (), EventMask ? EventMask : IN_ALL_EVENTS );
 		if ( descriptor == -1 ) {
 			std::stringstream errorStream;
 			auto path = Path.string ();
@@ -109,7 +148,7 @@ namespace Inotify {
 				throw std::runtime_error ( errorStream.str () );
 			}
 		}
-		savePath ( descriptor, Path );
+		return descriptor;
 	}
 
 	void Inotify::savePath ( int Descriptor, const fs::path& Path ) {
@@ -144,11 +183,19 @@ namespace Inotify {
 		if ( Stopped ) {
 			return std::nullopt;
 		}
-		auto event = EventQueue.front ();
+		auto event = std::move ( EventQueue.front () );
 		EventQueue.pop ();
 		return event;
 	}
 
+	void Inotify::Resize ( size_t Bytes ) {
+		// Room for the longest name, fanotify events also carry a handle of the folder
+		Bytes = std::max ( Bytes, size_t { PATH_MAX } );
+		if ( EventBuffer.size () != Bytes ) {
+			EventBuffer.assign ( Bytes, 0 );
+		}
+	}
+
 	void Inotify::Stop () {
 		Stopped = true;
 		sendStopSignal ();
@@ -183,38 +230,54 @@ namespace Inotify {
 	}
 
 	void Inotify::fetchEvents ( int Size, std::vector<SystemEvent>& Events ) {
-		decltype ( EventSize ) i { 0 };
-		auto buffer = EventBuffer.data ();
-		while ( i < Size ) {
-			auto event = reinterpret_cast<inotify_event*>( &buffer[ i ] );
+		if ( Tree ) {
+			Tree->Decode ( EventBuffer.data (), Size, Events );
+			return;
+		}
+		// Only the mask is looked at until someone turns out to listen, IN_ISDIR tells folders without a stat,
+		// which would fail for removed ones anyway
+		for ( int i = 0; i + static_cast<int> ( EventSize ) <= Size; ) {
+			auto event = reinterpret_cast<const inotify_event*> ( &EventBuffer[ i ] );
 			i += EventSize + event->len;
 			if ( event->mask & IN_IGNORED ) {
 				deleteDescriptor ( event->wd );
+				continue;
+			}
+			if ( event->mask & IN_Q_OVERFLOW ) {
+				Events.emplace_back ( event->mask, fs::path (), false );
+				continue;
+			}
+			if ( !listening ( static_cast<Action> ( event->mask ) ) ) {
+				continue;
+			}
+			auto folder = Folders.find ( event->wd );
+			if ( folder == Folders.end () ) {
+				continue;
+			}
+			auto directory = ( event->mask & IN_ISDIR ) != 0;
+			if ( event->len && event->name[ 0 ] ) {
+				Events.emplace_back ( event->mask, folder->second / event->name, directory );
 			} else {
-				auto path = Folders.at ( event->wd ) / std::string ( event->name );
-				if ( !path.empty () ) {
-					SystemEvent fsEvent ( event->mask, path, fs::is_directory ( path ) );
-					Events.push_back ( fsEvent );
-				}
+				Events.emplace_back ( event->mask, folder->second, directory );
 			}
 		}
 	}
 
 	void Inotify::deleteDescriptor ( int Descriptor ) {
-		Descriptors.erase ( Folders.at ( Descriptor ) );
-		Folders.erase ( Descriptor );
+		auto folder = Folders.find ( Descriptor );
+		if ( folder != Folders.end () ) {
+			Descriptors.erase ( folder->second );
+			Folders.erase ( folder );
+		}
 	}
 
 	void Inotify::filterEvents ( std::vector<SystemEvent>& Events ) {
-		for ( auto event = Events.begin (); event < Events.end (); ) {
-			auto currentEvent = *event;
-			if ( isIgnored ( currentEvent.Path ) ) {
-				event = Events.erase ( event );
-			} else {
-				EventQueue.push ( currentEvent );
-				++event;
+		for ( auto& event : Events ) {
+			if ( !isIgnored ( event.Path ) ) {
+				EventQueue.push ( std::move ( event ) );
 			}
 		}
+		Events.clear ();
 	}
 
 	void Inotify::Go () {
@@ -238,7 +301,8 @@ namespace Inotify {
 		}
 		auto& path = systemEvent->Path;
 		auto isFolder = systemEvent->Directory;
-		if ( isFolder && static_cast<bool>(event & Action::create ) ) {
+		// The whole tree backend reports what appears inside a new folder by itself, a walk would repeat it
+		if ( isFolder && static_cast<bool>(event & Action::create ) && !Tree ) {
 			attachFolder ( path, observer );
 		} else {
 			( *observer ) ( Notification { event, path, isFolder } );
@@ -255,26 +319,27 @@ namespace Inotify {
 	}
 
 	void Inotify::attachFolder ( const std::filesystem::path& Folder, const EventObserver* Handler ) {
-		( *Handler ) ( Notification { Action::create | Action::isDir, Folder, true } );
-		namespace fs = std::filesystem;
-		std::error_code error;
-		fs::directory_iterator it ( Folder, fs::directory_options::follow_directory_symlink, error );
-		fs::directory_iterator end;
-		std::vector<fs::directory_entry> folders;
-		for ( ; it != end; it.increment ( error ) ) {
-			auto& path = *it;
-			auto directory = ( fs::is_directory ( path ) && !fs::is_symlink ( path ) );
-			if ( directory ) {
-				folders.push_back ( path );
-			} else {
-				auto observer = listening ( Action::create );
-				( *observer ) ( Notification { Action::create, path, false } );
+		auto files = listening ( Action::create );
+		std::mutex lock;
+		Walker walker ( [ & ] ( const fs::path& Path, bool Directory ) {
+			if ( Directory && isIgnored ( Path ) ) {
+				return false;
 			}
-		}
-		WatchPath ( Folder );
-		for ( auto& folder : folders ) {
-			attachFolder ( folder, Handler );
-		}
+			auto descriptor = Directory ? addWatch ( Path ) : -1;
+			std::lock_guard<std::mutex> guard ( lock );
+			if ( !Directory ) {
+				if ( files ) {
+					( *files ) ( Notification { Action::create, Path, false } );
+				}
+				return true;
+			}
+			if ( descriptor != -1 ) {
+				savePath ( descriptor, Path );
+			}
+			( *Handler ) ( Notification { Action::create | Action::isDir, Path, true } );
+			return true;
+		}, true );
+		walker.Walk ( Folder );
 	}
 }
 #endif
\ No newline at end of file
@@ -17,6 +17,7 @@
 #include <vector>
 #include <chrono>
 #include <thread>
+#include <unordered_map>
 #include <atomic>
 #include <functional>
 #define EventsLimit 1024
@@ -68,9 +69,15 @@ namespace Inotify {
 
 	using EventObserver = std::function<void ( Notification )>;
 
+	class Fanotify;
+
 	class Inotify {
+		// The benchmarks feed fetchEvents a synthetic event buffer
+		friend struct Benchmark;
 	public:
 		std::vector<std::string> IgnoreFolders;
+		// Watch a folder with one fanotify mark when allowed, see fanotify.h, instead of a watch per folder
+		bool WholeTree;
 
 		Inotify ();
 		~Inotify ();
@@ -79,12 +86,14 @@ namespace Inotify {
 		void Subscribe ( const std::vector<Action>& Events, const EventObserver& EventObserver );
 		void Go ();
 		void Stop ();
+		// Bytes taken by one read, set before Go
+		void Resize ( size_t Bytes );
 		[[maybe_unused]] void ReleasePath ( const std::filesystem::path& File );
 	private:
 		std::map<Action, EventObserver> Observer;
 		uint32_t EventMask;
 		std::queue<SystemEvent> EventQueue;
-		std::map<int, std::filesystem::path> Folders;
+		std::unordered_map<int, std::filesystem::path> Folders;
 		std::map<std::filesystem::path, int> Descriptors;
 		int InotifyDescriptor;
 		std::atomic<bool> Stopped;
@@ -96,17 +105,21 @@ namespace Inotify {
 		int StopPipeDescriptor[2];
 		const int PipeReadIndex;
 		const int PipeWriteIndex;
+		std::unique_ptr<Fanotify> Tree;
 
 		void waitForEvent ();
 		ssize_t readEvents ();
 		void fetchEvents ( int Size, std::vector<SystemEvent>& Events );
 		void filterEvents ( std::vector<SystemEvent>& Events );
 		void sendStopSignal ();
+		bool watchTree ( const std::filesystem::path& Path );
+		void releaseTree ();
 		bool isIgnored ( const std::filesystem::path& Path );
 		EventObserver* listening ( Action Event );
 		void attachFolder ( const std::filesystem::path& Folder, const EventObserver* Handler );
 		std::optional<SystemEvent> getNext ();
 		static void checkPath ( const std::filesystem::path& Path );
+		int addWatch ( const std::filesystem::path& Path ) const;
 		void savePath ( int Descriptor, const std::filesystem::path& Path );
 		void deleteDescriptor ( int Descriptor );
 	};
@@ -1,8 +1,120 @@
 #include "json.h"
+#include "1c/types.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <locale>
+#include <sstream>
+#include <type_traits>
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define JSON_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 #include <utility>
 #include <memory>
 
 namespace JSON {
+	namespace {
+		constexpr uint32_t Unlimited { 0xFFFFFFFF };
+
+#ifdef JSON_SSE2
+		inline unsigned first ( int Mask ) {
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanForward ( &index, Mask );
+			return index;
+#else
+			return __builtin_ctz ( Mask );
+#endif
+		}
+
+		// Marks the units which need escaping or are above Limit
+		template <typename Unit>
+		__m128i special ( __m128i Value, uint32_t Limit ) {
+			auto zero = _mm_setzero_si128 ();
+			__m128i result;
+			if constexpr ( sizeof ( Unit ) == 1 ) {
+				result = _mm_or_si128 ( _mm_cmpeq_epi8 ( Value, _mm_set1_epi8 ( '"' ) ),
+										_mm_cmpeq_epi8 ( Value, _mm_set1_epi8 ( '\\' ) ) );
+				result = _mm_or_si128 ( result, _mm_cmpeq_epi8 ( _mm_subs_epu8 ( Value, _mm_set1_epi8 ( 0x1F ) ), zero ) );
+				if ( Limit < 0xFF ) {
+					auto within = _mm_cmpeq_epi8 ( _mm_subs_epu8 ( Value, _mm_set1_epi8 ( static_cast<char> ( Limit ) ) ), zero );
+					result = _mm_or_si128 ( result, _mm_andnot_si128 ( within, _mm_set1_epi8 ( -1 ) ) );
+				}
+			} else if constexpr ( sizeof ( Unit ) == 2 ) {
+				result = _mm_or_si128 ( _mm_cmpeq_epi16 ( Value, _mm_set1_epi16 ( '"' ) ),
+										_mm_cmpeq_epi16 ( Value, _mm_set1_epi16 ( '\\' ) ) );
+				result = _mm_or_si128 ( result, _mm_cmpeq_epi16 ( _mm_subs_epu16 ( Value, _mm_set1_epi16 ( 0x1F ) ), zero ) );
+				if ( Limit < 0xFFFF ) {
+					auto limit = _mm_set1_epi16 ( static_cast<short> ( Limit ) );
+					auto within = _mm_cmpeq_epi16 ( _mm_subs_epu16 ( Value, limit ), zero );
+					result = _mm_or_si128 ( result, _mm_andnot_si128 ( within, _mm_set1_epi16 ( -1 ) ) );
+				}
+			} else {
+				auto bias = _mm_set1_epi32 ( static_cast<int> ( 0x80000000 ) );
+				auto biased = _mm_xor_si128 ( Value, bias );
+				result = _mm_or_si128 ( _mm_cmpeq_epi32 ( Value, _mm_set1_epi32 ( '"' ) ),
+										_mm_cmpeq_epi32 ( Value, _mm_set1_epi32 ( '\\' ) ) );
+				result = _mm_or_si128 ( result, _mm_cmplt_epi32 ( biased, _mm_set1_epi32 ( static_cast<int> ( 0x80000020 ) ) ) );
+				if ( Limit != Unlimited ) {
+					auto limit = _mm_set1_epi32 ( static_cast<int> ( Limit ^ 0x80000000 ) );
+					result = _mm_or_si128 ( result, _mm_cmpgt_epi32 ( biased, limit ) );
+				}
+			}
+			return result;
+		}
+#endif
+
+		template <typename Unit>
+		bool plain ( Unit Value, uint32_t Limit ) {
+			uint32_t c = static_cast<std::make_unsigned_t<Unit>> ( Value );
+			return c >= 0x20 && c != '"' && c != '\\' && c <= Limit;
+		}
+
+		// Length of the leading run which can be copied as is: no quotes, backslashes, control
+		// characters and no units above Limit. Short runs, typical for non-ASCII text, are checked
+		// one by one, then SSE2 checks 64 bytes per step
+		template <typename Unit>
+		size_t clean ( const Unit* Data, size_t Size, uint32_t Limit ) {
+			size_t i { 0 };
+			for ( auto head = std::min<size_t> ( Size, 8 ); i < head; ++i ) {
+				if ( !plain ( Data[ i ], Limit ) ) {
+					return i;
+				}
+			}
+#ifdef JSON_SSE2
+			constexpr size_t step = 16 / sizeof ( Unit );
+			for ( ; i + 4 * step <= Size; i += 4 * step ) {
+				auto block = reinterpret_cast<const __m128i*> ( Data + i );
+				auto found = _mm_or_si128 (
+						_mm_or_si128 ( special<Unit> ( _mm_loadu_si128 ( block ), Limit ),
+									   special<Unit> ( _mm_loadu_si128 ( block + 1 ), Limit ) ),
+						_mm_or_si128 ( special<Unit> ( _mm_loadu_si128 ( block + 2 ), Limit ),
+									   special<Unit> ( _mm_loadu_si128 ( block + 3 ), Limit ) ) );
+				if ( _mm_movemask_epi8 ( found ) ) {
+					break;
+				}
+			}
+			for ( ; i + step <= Size; i += step ) {
+				auto mask = _mm_movemask_epi8 (
+						special<Unit> ( _mm_loadu_si128 ( reinterpret_cast<const __m128i*> ( Data + i ) ), Limit ) );
+				if ( mask ) {
+					return i + first ( mask ) / sizeof ( Unit );
+				}
+			}
+#endif
+			while ( i < Size && plain ( Data[ i ], Limit ) ) {
+				++i;
+			}
+			return i;
+		}
+	}
+
 	std::wstring toHex ( wchar_t Value ) {
 		std::wstring result;
 		result += Hex[ ( Value & 0xF000 ) >> 12 ];
@@ -13,8 +125,16 @@ namespace JSON {
 	}
 
 	void escape ( std::wstring* Result, const std::wstring& s ) {
-		for ( wchar_t c : s ) {
-			switch ( c ) {
+		auto data = s.data ();
+		auto size = s.size ();
+		for ( size_t i = 0; i < size; ) {
+			auto run = clean ( data + i, size - i, Unlimited );
+			Result->append ( data + i, run );
+			i += run;
+			if ( i == size ) {
+				break;
+			}
+			switch ( wchar_t c = data[ i++ ] ) {
 				case '"':
 					Result->append ( L"\\\"" );
 					break;
@@ -37,13 +157,402 @@ namespace JSON {
 					Result->append ( L"\\t" );
 					break;
 				default:
-					if ( '\x00' <= c && c <= '\x1f' ) {
-						Result->append ( L"\\u" + toHex ( c ) );
-					} else {
-						Result->push_back ( c );
+					Result->append ( L"\\u00" );
+					Result->push_back ( Hex[ ( c & 0xF0 ) >> 4 ] );
+					Result->push_back ( Hex[ c & 0x0F ] );
+			}
+		}
+	}
+
+	namespace {
+		template <typename Char>
+		bool isBlank ( Char c ) {
+			return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+		}
+
+		template <typename Char>
+		int fromHex ( Char c ) {
+			if ( c >= '0' && c <= '9' ) return c - '0';
+			if ( c >= 'a' && c <= 'f' ) return c - 'a' + 10;
+			if ( c >= 'A' && c <= 'F' ) return c - 'A' + 10;
+			return -1;
+		}
+
+		template <typename Char>
+		bool isDigit ( Char c ) {
+			return c >= '0' && c <= '9';
+		}
+	}
+
+	template <typename Char>
+	bool parseStrings ( std::basic_string_view<Char> Source, std::vector<std::wstring>& Result ) {
+		Reader<Char> reader ( Source );
+		if ( reader.Next () != Token::BeginArray ) {
+			return false;
+		}
+		for ( auto token = reader.Next (); token != Token::EndArray; token = reader.Next () ) {
+			if ( token != Token::String || !unescape ( reader.Value (), Result.emplace_back () ) ) {
+				return false;
+			}
+		}
+		return reader.Next () == Token::End;
+	}
+
+	// Lists come either as a JSON array of strings or as newline-delimited text
+	template <typename Char>
+	bool parseList ( std::basic_string_view<Char> Source, std::vector<std::wstring>& Items, bool& Json ) {
+		auto first = std::find_if_not ( Source.begin (), Source.end (), isBlank<Char> );
+		Json = first != Source.end () && *first == '[';
+		if ( Json ) {
+			return parseStrings ( Source, Items );
+		}
+		if ( Source.empty () ) {
+			return true;
+		}
+		size_t start { 0 };
+		while ( true ) {
+			auto end = std::min ( Source.find ( '\n', start ), Source.size () );
+			auto& item = Items.emplace_back ( Source.begin () + start, Source.begin () + end );
+			if ( !item.empty () && item.back () == '\r' ) {
+				item.pop_back ();
+			}
+			// A newline at the very end closes the last item rather than starting an empty one
+			if ( end + 1 >= Source.size () ) {
+				return true;
+			}
+			start = end + 1;
+		}
+	}
+
+	template <typename Char>
+	Reader<Char>::Reader ( View Source ) : Source ( Source ) {}
+
+	template <typename Char>
+	Token Reader<Char>::Next () {
+		if ( Error ) {
+			return Token::Error;
+		}
+		blank ();
+		auto size = Source.size ();
+		if ( State == Expect::CommaOrEnd ) {
+			if ( Current == size ) {
+				return fail ( "Unexpected end of data" );
+			}
+			if ( Source[ Current ] != ',' ) {
+				return close ();
+			}
+			++Current;
+			blank ();
+			State = Stack.back () == '{' ? Expect::Key : Expect::Value;
+		}
+		if ( State == Expect::Done ) {
+			return Current == size ? Token::End : fail ( "Unexpected data after the end of document" );
+		}
+		if ( Current == size ) {
+			return fail ( "Unexpected end of data" );
+		}
+		auto c = Source[ Current ];
+		if ( State == Expect::KeyOrEnd ) {
+			if ( c == '}' ) {
+				return close ();
+			}
+			State = Expect::Key;
+		} else if ( State == Expect::ValueOrEnd ) {
+			if ( c == ']' ) {
+				return close ();
+			}
+			State = Expect::Value;
+		}
+		if ( State == Expect::Key ) {
+			if ( c != '"' ) {
+				return fail ( "Object key expected" );
+			}
+			if ( !string () ) {
+				return Token::Error;
+			}
+			blank ();
+			if ( Current == size || Source[ Current ] != ':' ) {
+				return fail ( "Colon expected after object key" );
+			}
+			++Current;
+			State = Expect::Value;
+			return Token::Key;
+		}
+		return value ();
+	}
+
+	// Skips the object or array which the last token has opened
+	template <typename Char>
+	bool Reader<Char>::Skip () {
+		auto from = Start;
+		size_t depth { 1 };
+		while ( depth ) {
+			switch ( Next () ) {
+				case Token::BeginObject:
+				case Token::BeginArray:
+					++depth;
+					break;
+				case Token::EndObject:
+				case Token::EndArray:
+					--depth;
+					break;
+				case Token::Error:
+				case Token::End:
+					return false;
+				default:
+					break;
+			}
+		}
+		Start = from;
+		Quoted = false;
+		return true;
+	}
+
+	template <typename Char>
+	Token Reader<Char>::fail ( const char* Message ) {
+		Start = Finish = Current;
+		Quoted = false;
+		Error = Message;
+		return Token::Error;
+	}
+
+	template <typename Char>
+	void Reader<Char>::blank () {
+		auto size = Source.size ();
+		while ( Current < size && isBlank ( Source[ Current ] ) ) {
+			++Current;
+		}
+	}
+
+	template <typename Char>
+	void Reader<Char>::after () {
+		State = Stack.empty () ? Expect::Done : Expect::CommaOrEnd;
+	}
+
+	template <typename Char>
+	Token Reader<Char>::value () {
+		Start = Current;
+		Quoted = false;
+		Token token;
+		switch ( Source[ Current ] ) {
+			case '{':
+			case '[': {
+				auto object = Source[ Current++ ] == '{';
+				Finish = Current;
+				Stack.push_back ( object ? '{' : '[' );
+				State = object ? Expect::KeyOrEnd : Expect::ValueOrEnd;
+				return object ? Token::BeginObject : Token::BeginArray;
+			}
+			case '"':
+				if ( !string () ) {
+					return Token::Error;
+				}
+				token = Token::String;
+				break;
+			case 't':
+				if ( !literal ( "true" ) ) {
+					return Token::Error;
+				}
+				token = Token::True;
+				break;
+			case 'f':
+				if ( !literal ( "false" ) ) {
+					return Token::Error;
+				}
+				token = Token::False;
+				break;
+			case 'n':
+				if ( !literal ( "null" ) ) {
+					return Token::Error;
+				}
+				token = Token::Null;
+				break;
+			default:
+				if ( !number () ) {
+					return Token::Error;
+				}
+				token = Token::Number;
+		}
+		after ();
+		return token;
+	}
+
+	template <typename Char>
+	Token Reader<Char>::close () {
+		auto c = Source[ Current ];
+		if ( c != ( Stack.back () == '{' ? '}' : ']' ) ) {
+			return fail ( "Comma or closing bracket expected" );
+		}
+		Start = Current;
+		Finish = ++Current;
+		Quoted = false;
+		Stack.pop_back ();
+		after ();
+		return c == '}' ? Token::EndObject : Token::EndArray;
+	}
+
+	// String contents are skipped by clean runs, so only quotes, escapes and control characters are looked at
+	template <typename Char>
+	bool Reader<Char>::string () {
+		auto data = Source.data ();
+		auto size = Source.size ();
+		Start = Current++;
+		while ( true ) {
+			Current += clean ( data + Current, size - Current, Unlimited );
+			if ( Current == size ) {
+				fail ( "Unterminated string" );
+				return false;
+			}
+			auto c = data[ Current ];
+			if ( c == '"' ) {
+				Finish = ++Current;
+				Quoted = true;
+				return true;
+			}
+			if ( c != '\\' || Current + 1 == size ) {
+				fail ( "Control character in string" );
+				return false;
+			}
+			switch ( data[ Current + 1 ] ) {
+				case '"':
+				case '\\':
+				case '/':
+				case 'b':
+				case 'f':
+				case 'n':
+				case 'r':
+				case 't':
+					Current += 2;
+					break;
+				case 'u':
+					if ( Current + 6 > size || fromHex ( data[ Current + 2 ] ) < 0 || fromHex ( data[ Current + 3 ] ) < 0
+						 || fromHex ( data[ Current + 4 ] ) < 0 || fromHex ( data[ Current + 5 ] ) < 0 ) {
+						fail ( "Invalid unicode escape" );
+						return false;
 					}
+					Current += 6;
+					break;
+				default:
+					fail ( "Invalid escape sequence" );
+					return false;
+			}
+		}
+	}
+
+	template <typename Char>
+	bool Reader<Char>::number () {
+		auto size = Source.size ();
+		auto digits = [ & ] () {
+			auto from = Current;
+			while ( Current < size && isDigit ( Source[ Current ] ) ) {
+				++Current;
+			}
+			return Current > from;
+		};
+		if ( Source[ Current ] == '-' ) {
+			++Current;
+		}
+		if ( Current < size && Source[ Current ] == '0' ) {
+			++Current;
+		} else if ( !digits () ) {
+			fail ( "Unexpected character" );
+			return false;
+		}
+		if ( Current < size && Source[ Current ] == '.' ) {
+			++Current;
+			if ( !digits () ) {
+				fail ( "Digits expected after decimal point" );
+				return false;
 			}
 		}
+		if ( Current < size && ( Source[ Current ] == 'e' || Source[ Current ] == 'E' ) ) {
+			++Current;
+			if ( Current < size && ( Source[ Current ] == '+' || Source[ Current ] == '-' ) ) {
+				++Current;
+			}
+			if ( !digits () ) {
+				fail ( "Digits expected in exponent" );
+				return false;
+			}
+		}
+		Finish = Current;
+		return true;
+	}
+
+	template <typename Char>
+	bool Reader<Char>::literal ( const char* Word ) {
+		auto size = Source.size ();
+		for ( ; *Word; ++Word, ++Current ) {
+			if ( Current == size || Source[ Current ] != *Word ) {
+				fail ( "Unexpected character" );
+				return false;
+			}
+		}
+		Finish = Current;
+		return true;
+	}
+
+	// Decodes a raw string into UTF-16 code units, the way 1C strings keep them
+	template <typename Char>
+	bool unescape ( std::basic_string_view<Char> Raw, std::wstring& Result ) {
+		auto data = Raw.data ();
+		auto size = Raw.size ();
+		Result.reserve ( Result.size () + size );
+		for ( size_t i = 0; i < size; ) {
+			auto run = clean ( data + i, size - i, std::is_same_v<Char, char> ? 0x7F : Unlimited );
+			for ( auto end = i + run; i < end; ++i ) {
+				Result.push_back ( static_cast<wchar_t> ( data[ i ] ) );
+			}
+			if ( i == size ) {
+				break;
+			}
+			uint32_t c = static_cast<std::make_unsigned_t<Char>> ( data[ i++ ] );
+			if ( c == '\\' ) {
+				if ( i == size ) {
+					return false;
+				}
+				switch ( c = data[ i++ ] ) {
+					case 'b': c = '\b'; break;
+					case 'f': c = '\f'; break;
+					case 'n': c = '\n'; break;
+					case 'r': c = '\r'; break;
+					case 't': c = '\t'; break;
+					case 'u':
+						if ( i + 4 > size ) {
+							return false;
+						}
+						c = 0;
+						for ( auto end = i + 4; i < end; ++i ) {
+							auto digit = fromHex ( data[ i ] );
+							if ( digit < 0 ) {
+								return false;
+							}
+							c = ( c << 4 ) | digit;
+						}
+						break;
+					default:
+						break;
+				}
+			} else if ( std::is_same_v<Char, char> && c >= 0x80 ) {
+				auto start = i - 1;
+				int extra = ( c & 0xE0 ) == 0xC0 ? 1 : ( c & 0xF0 ) == 0xE0 ? 2 : ( c & 0xF8 ) == 0xF0 ? 3 : 0;
+				c &= 0x3F >> extra;
+				for ( auto n = extra; n && i < size && ( data[ i ] & 0xC0 ) == 0x80; --n ) {
+					c = ( c << 6 ) | ( data[ i++ ] & 0x3F );
+				}
+				if ( !extra || i - start != static_cast<size_t> ( extra + 1 ) ) {
+					c = 0xFFFD;
+					i = start + 1;
+				}
+				if ( c > 0xFFFF ) {
+					c -= 0x10000;
+					Result.push_back ( static_cast<wchar_t> ( 0xD800 + ( c >> 10 ) ) );
+					c = 0xDC00 + ( c & 0x3FF );
+				}
+			}
+			Result.push_back ( static_cast<wchar_t> ( c ) );
+		}
+		return true;
 	}
 
 	Value::Value ( std::wstring Name ) : Name ( std::move ( Name ) ) {}
@@ -67,7 +576,7 @@ namespace JSON {
 		Result->push_back ( L'\"' );
 	}
 
-	[[maybe_unused]] void Number::Set ( int Value ) {
+	void Number::Set ( int64_t Value ) {
 		Storage = std::to_wstring ( Value );
 	}
 
@@ -106,4 +615,583 @@ namespace JSON {
 		ItemsPresentation ( Result );
 		Result->push_back ( L']' );
 	}
-}
\ No newline at end of file
+
+	template <typename Char>
+	Writer<Char>& Writer<Char>::BeginObject () {
+		next ();
+		Output.push_back ( '{' );
+		Separate = false;
+		return *this;
+	}
+
+	template <typename Char>
+	Writer<Char>& Writer<Char>::EndObject () {
+		Output.push_back ( '}' );
+		Separate = true;
+		return *this;
+	}
+
+	template <typename Char>
+	Writer<Char>& Writer<Char>::BeginArray () {
+		next ();
+		Output.push_back ( '[' );
+		Separate = false;
+		return *this;
+	}
+
+	template <typename Char>
+	Writer<Char>& Writer<Char>::EndArray () {
+		Output.push_back ( ']' );
+		Separate = true;
+		return *this;
+	}
+
+	template <typename Char>
+	Writer<Char>& Writer<Char>::Key ( std::wstring_view Name ) {
+		next ();
+		quote ( Name );
+		Output.push_back ( ':' );
+		Separate = false;
+		return *this;
+	}
+
+	template <typename Char>
+	Writer<Char>& Writer<Char>::String ( std::wstring_view Value ) {
+		next ();
+		quote ( Value );
+		Separate = true;
+		return *this;
+	}
+
+	template <typename Char>
+	Writer<Char>& Writer<Char>::String ( std::string_view Value ) {
+		next ();
+		Output.push_back ( '"' );
+		if constexpr ( std::is_same_v<Char, char> ) {
+			auto data = Value.data ();
+			auto size = Value.size ();
+			for ( size_t i = 0; i < size; ) {
+				auto run = clean ( data + i, size - i, Unlimited );
+				Output.append ( data + i, run );
+				i += run;
+				if ( i < size ) {
+					put ( static_cast<unsigned char> ( data[ i++ ] ) );
+				}
+			}
+		} else {
+			auto bytes = reinterpret_cast<const unsigned char*> ( Value.data () );
+			auto size = Value.size ();
+			for ( size_t i = 0; i < size; ) {
+				auto run = clean ( Value.data () + i, size - i, 0x7F );
+				widen ( bytes + i, run );
+				i += run;
+				if ( i == size ) {
+					break;
+				}
+				char32_t code = bytes[ i++ ];
+				if ( code >= 0x80 ) {
+					auto start = i - 1;
+					int extra = ( code & 0xE0 ) == 0xC0 ? 1 : ( code & 0xF0 ) == 0xE0 ? 2 : ( code & 0xF8 ) == 0xF0 ? 3 : 0;
+					code &= 0x3F >> extra;
+					for ( auto n = extra; n && i < size && ( bytes[ i ] & 0xC0 ) == 0x80; --n ) {
+						code = ( code << 6 ) | ( bytes[ i++ ] & 0x3F );
+					}
+					if ( !extra || i - start != static_cast<size_t> ( extra + 1 ) ) {
+						code = 0xFFFD;
+						i = start + 1;
+					}
+				}
+				put ( code );
+			}
+		}
+		Output.push_back ( '"' );
+		Separate = true;
+		return *this;
+	}
+
+	template <typename Char>
+	Writer<Char>& Writer<Char>::Number ( int64_t Value ) {
+		next ();
+		char digits[24];
+		auto end = std::to_chars ( digits, digits + sizeof digits, Value ).ptr;
+		Output.append ( digits, end );
+		Separate = true;
+		return *this;
+	}
+
+	template <typename Char>
+	Writer<Char>& Writer<Char>::Number ( double Value ) {
+		// JSON has no NaN or infinity
+		if ( !std::isfinite ( Value ) ) {
+			return Null ();
+		}
+		next ();
+		// The shortest text that reads back the same, and with a dot whatever locale 1C has set
+		char digits[32];
+		auto end = std::to_chars ( digits, digits + sizeof digits, Value ).ptr;
+		Output.append ( digits, end );
+		Separate = true;
+		return *this;
+	}
+
+	template <typename Char>
+	Writer<Char>& Writer<Char>::Bool ( bool Value ) {
+		next ();
+		auto text = Value ? "true" : "false";
+		Output.append ( text, text + ( Value ? 4 : 5 ) );
+		Separate = true;
+		return *this;
+	}
+
+	template <typename Char>
+	Writer<Char>& Writer<Char>::Null () {
+		next ();
+		auto text = "null";
+		Output.append ( text, text + 4 );
+		Separate = true;
+		return *this;
+	}
+
+	template <typename Char>
+	Writer<Char>& Writer<Char>::Raw ( std::basic_string_view<Char> Json ) {
+		next ();
+		Output.append ( Json );
+		Separate = true;
+		return *this;
+	}
+
+	template <typename Char>
+	void Writer<Char>::Clear () {
+		Output.clear ();
+		Separate = false;
+	}
+
+	template <typename Char>
+	void Writer<Char>::next () {
+		if ( Separate ) {
+			Output.push_back ( ',' );
+		}
+	}
+
+	template <typename Char>
+	void Writer<Char>::quote ( std::wstring_view Value ) {
+		// Units which can be copied without conversion: any of the same width, BMP ones into UTF-16, ASCII into UTF-8
+		constexpr uint32_t limit = std::is_same_v<Char, char> ? 0x7F
+								   : sizeof ( Char ) >= sizeof ( wchar_t ) ? Unlimited : 0xFFFF;
+		Output.push_back ( '"' );
+		auto data = Value.data ();
+		auto size = Value.size ();
+		for ( size_t i = 0; i < size; ) {
+			auto run = clean ( data + i, size - i, limit );
+			if constexpr ( sizeof ( Char ) == sizeof ( wchar_t ) ) {
+				Output.append ( reinterpret_cast<const Char*> ( data + i ), run );
+			} else {
+				widen ( data + i, run );
+			}
+			i += run;
+			if ( i == size ) {
+				break;
+			}
+			char32_t code = static_cast<std::make_unsigned_t<wchar_t>> ( data[ i++ ] );
+			if constexpr ( sizeof ( Char ) != sizeof ( wchar_t ) ) {
+				if ( code >= 0xD800 && code <= 0xDBFF && i < size ) {
+					char32_t low = static_cast<std::make_unsigned_t<wchar_t>> ( data[ i ] );
+					if ( low >= 0xDC00 && low <= 0xDFFF ) {
+						code = 0x10000 + ( ( code - 0xD800 ) << 10 ) + ( low - 0xDC00 );
+						++i;
+					}
+				}
+			}
+			put ( code );
+		}
+		Output.push_back ( '"' );
+	}
+
+	// Copies units which need no conversion, appending an iterator range of another type would build a temporary
+	template <typename Char>
+	template <typename Unit>
+	void Writer<Char>::widen ( const Unit* Data, size_t Size ) {
+		if ( Size < 16 ) {
+			for ( auto end = Data + Size; Data != end; ++Data ) {
+				Output.push_back ( static_cast<Char> ( *Data ) );
+			}
+			return;
+		}
+		auto size = Output.size ();
+		Output.resize ( size + Size );
+		std::copy ( Data, Data + Size, Output.begin () + size );
+	}
+
+	// Appends one code point, escaped when JSON requires it and encoded into Char
+	template <typename Char>
+	void Writer<Char>::put ( char32_t Code ) {
+		if ( Code < 0x20 || Code == '"' || Code == '\\' ) {
+			Output.push_back ( '\\' );
+			switch ( Code ) {
+				case '"':
+				case '\\':
+					Output.push_back ( static_cast<Char> ( Code ) );
+					break;
+				case '\b':
+					Output.push_back ( 'b' );
+					break;
+				case '\f':
+					Output.push_back ( 'f' );
+					break;
+				case '\n':
+					Output.push_back ( 'n' );
+					break;
+				case '\r':
+					Output.push_back ( 'r' );
+					break;
+				case '\t':
+					Output.push_back ( 't' );
+					break;
+				default:
+					Output.push_back ( 'u' );
+					Output.push_back ( '0' );
+					Output.push_back ( '0' );
+					Output.push_back ( Hex[ Code >> 4 ] );
+					Output.push_back ( Hex[ Code & 0x0F ] );
+			}
+		} else if constexpr ( std::is_same_v<Char, char> ) {
+			if ( ( Code >= 0xD800 && Code <= 0xDFFF ) || Code > 0x10FFFF ) {
+				Code = 0xFFFD;
+			}
+			if ( Code < 0x80 ) {
+				Output.push_back ( static_cast<char> ( Code ) );
+			} else if ( Code < 0x800 ) {
+				Output.push_back ( static_cast<char> ( 0xC0 | ( Code >> 6 ) ) );
+				Output.push_back ( static_cast<char> ( 0x80 | ( Code & 0x3F ) ) );
+			} else if ( Code < 0x10000 ) {
+				Output.push_back ( static_cast<char> ( 0xE0 | ( Code >> 12 ) ) );
+				Output.push_back ( static_cast<char> ( 0x80 | ( ( Code >> 6 ) & 0x3F ) ) );
+				Output.push_back ( static_cast<char> ( 0x80 | ( Code & 0x3F ) ) );
+			} else {
+				Output.push_back ( static_cast<char> ( 0xF0 | ( Code >> 18 ) ) );
+				Output.push_back ( static_cast<char> ( 0x80 | ( ( Code >> 12 ) & 0x3F ) ) );
+				Output.push_back ( static_cast<char> ( 0x80 | ( ( Code >> 6 ) & 0x3F ) ) );
+				Output.push_back ( static_cast<char> ( 0x80 | ( Code & 0x3F ) ) );
+			}
+		} else if constexpr ( sizeof ( Char ) == 2 ) {
+			if ( Code > 0xFFFF ) {
+				Code -= 0x10000;
+				Output.push_back ( static_cast<Char> ( 0xD800 + ( Code >> 10 ) ) );
+				Code = 0xDC00 + ( Code & 0x3FF );
+			}
+			Output.push_back ( static_cast<Char> ( Code ) );
+		} else {
+			Output.push_back ( static_cast<Char> ( Code ) );
+		}
+	}
+
+	Encoding encoding ( std::wstring_view Format ) {
+		if ( Format.find ( L"cbor" ) != std::wstring_view::npos ) {
+			return Encoding::CBOR;
+		}
+		if ( Format.find ( L"msgpack" ) != std::wstring_view::npos ) {
+			return Encoding::MessagePack;
+		}
+		return Encoding::Text;
+	}
+
+	Binary::Binary ( Encoding Format, std::pmr::memory_resource* Memory )
+			: Cbor ( Format == Encoding::CBOR ), Output ( Memory ), Open ( Memory ) {}
+
+	Binary& Binary::BeginObject () {
+		begin ( true );
+		return *this;
+	}
+
+	Binary& Binary::EndObject () {
+		end ();
+		return *this;
+	}
+
+	Binary& Binary::BeginArray () {
+		begin ( false );
+		return *this;
+	}
+
+	Binary& Binary::EndArray () {
+		end ();
+		return *this;
+	}
+
+	Binary& Binary::Key ( std::wstring_view Name ) {
+		++Open.back ().Count;
+		text ( Name );
+		return *this;
+	}
+
+	Binary& Binary::String ( std::wstring_view Value ) {
+		item ();
+		text ( Value );
+		return *this;
+	}
+
+	Binary& Binary::String ( std::string_view Value ) {
+		item ();
+		header ( Value.size () );
+		Output.append ( Value );
+		return *this;
+	}
+
+	Binary& Binary::Number ( int64_t Value ) {
+		item ();
+		if ( Cbor ) {
+			if ( Value < 0 ) {
+				head ( 1, static_cast<uint64_t> ( -( Value + 1 ) ) );
+			} else {
+				head ( 0, Value );
+			}
+		} else if ( Value >= -32 && Value <= 0x7F ) {
+			Output.push_back ( static_cast<char> ( Value ) );
+		} else if ( Value > 0 ) {
+			head ( 0, Value );
+		} else if ( Value >= INT8_MIN ) {
+			Output.push_back ( static_cast<char> ( 0xD0 ) );
+			big<int8_t> ( Value );
+		} else if ( Value >= INT16_MIN ) {
+			Output.push_back ( static_cast<char> ( 0xD1 ) );
+			big<int16_t> ( Value );
+		} else if ( Value >= INT32_MIN ) {
+			Output.push_back ( static_cast<char> ( 0xD2 ) );
+			big<int32_t> ( Value );
+		} else {
+			Output.push_back ( static_cast<char> ( 0xD3 ) );
+			big<int64_t> ( Value );
+		}
+		return *this;
+	}
+
+	Binary& Binary::Number ( double Value ) {
+		item ();
+		uint64_t bits;
+		std::memcpy ( &bits, &Value, sizeof bits );
+		Output.push_back ( static_cast<char> ( Cbor ? 0xFB : 0xCB ) );
+		big ( bits );
+		return *this;
+	}
+
+	Binary& Binary::Bool ( bool Value ) {
+		item ();
+		Output.push_back ( static_cast<char> ( Cbor ? ( Value ? 0xF5 : 0xF4 ) : ( Value ? 0xC3 : 0xC2 ) ) );
+		return *this;
+	}
+
+	Binary& Binary::Null () {
+		item ();
+		Output.push_back ( static_cast<char> ( Cbor ? 0xF6 : 0xC0 ) );
+		return *this;
+	}
+
+	// Re-encodes a JSON value, numbers without fraction and exponent become integers when they fit
+	Binary& Binary::Raw ( std::wstring_view Json ) {
+		Reader<wchar_t> reader ( Json );
+		std::wstring value;
+		for ( auto token = reader.Next (); token != Token::End && token != Token::Error; token = reader.Next () ) {
+			switch ( token ) {
+				case Token::BeginObject:
+					BeginObject ();
+					break;
+				case Token::EndObject:
+					EndObject ();
+					break;
+				case Token::BeginArray:
+					BeginArray ();
+					break;
+				case Token::EndArray:
+					EndArray ();
+					break;
+				case Token::Key:
+				case Token::String:
+					value.clear ();
+					unescape ( reader.Value (), value );
+					token == Token::Key ? Key ( value ) : String ( std::wstring_view ( value ) );
+					break;
+				case Token::Number: {
+					auto raw = reader.Value ();
+					std::string digits ( raw.begin (), raw.end () );
+					int64_t integer;
+					auto end = digits.data () + digits.size ();
+					auto [ last, error ] = std::from_chars ( digits.data (), end, integer );
+					if ( error == std::errc () && last == end ) {
+						Number ( integer );
+					} else {
+						std::istringstream stream ( digits );
+						stream.imbue ( std::locale::classic () );
+						double real { 0 };
+						stream >> real;
+						Number ( real );
+					}
+					break;
+				}
+				case Token::True:
+				case Token::False:
+					Bool ( token == Token::True );
+					break;
+				default:
+					Null ();
+			}
+		}
+		return *this;
+	}
+
+	void Binary::Clear () {
+		Output.clear ();
+		Open.clear ();
+	}
+
+	void Binary::item () {
+		if ( !Open.empty () && !Open.back ().Map ) {
+			++Open.back ().Count;
+		}
+	}
+
+	void Binary::begin ( bool Map ) {
+		item ();
+		Open.push_back ( { Output.size (), 0, Map } );
+		if ( Cbor ) {
+			Output.push_back ( static_cast<char> ( Map ? 0xBF : 0x9F ) );
+		} else {
+			Output.push_back ( static_cast<char> ( Map ? 0xDF : 0xDD ) );
+			big<uint32_t> ( 0 );
+		}
+	}
+
+	void Binary::end () {
+		if ( Cbor ) {
+			Output.push_back ( static_cast<char> ( 0xFF ) );
+		} else {
+			auto& level = Open.back ();
+			for ( int i = 0; i < 4; ++i ) {
+				Output[ level.Header + 1 + i ] = static_cast<char> ( level.Count >> ( 24 - 8 * i ) );
+			}
+		}
+		Open.pop_back ();
+	}
+
+	// CBOR initial byte with the shortest argument, MessagePack unsigned integers share the layout
+	void Binary::head ( uint8_t Major, uint64_t Value ) {
+		if ( !Cbor ) {
+			if ( Value <= 0xFF ) {
+				Output.push_back ( static_cast<char> ( 0xCC ) );
+				big<uint8_t> ( Value );
+			} else if ( Value <= 0xFFFF ) {
+				Output.push_back ( static_cast<char> ( 0xCD ) );
+				big<uint16_t> ( Value );
+			} else if ( Value <= 0xFFFFFFFF ) {
+				Output.push_back ( static_cast<char> ( 0xCE ) );
+				big<uint32_t> ( Value );
+			} else {
+				Output.push_back ( static_cast<char> ( 0xCF ) );
+				big ( Value );
+			}
+			return;
+		}
+		Major <<= 5;
+		if ( Value < 24 ) {
+			Output.push_back ( static_cast<char> ( Major | Value ) );
+		} else if ( Value <= 0xFF ) {
+			Output.push_back ( static_cast<char> ( Major | 24 ) );
+			big<uint8_t> ( Value );
+		} else if ( Value <= 0xFFFF ) {
+			Output.push_back ( static_cast<char> ( Major | 25 ) );
+			big<uint16_t> ( Value );
+		} else if ( Value <= 0xFFFFFFFF ) {
+			Output.push_back ( static_cast<char> ( Major | 26 ) );
+			big<uint32_t> ( Value );
+		} else {
+			Output.push_back ( static_cast<char> ( Major | 27 ) );
+			big ( Value );
+		}
+	}
+
+	void Binary::header ( size_t Size ) {
+		if ( Cbor ) {
+			head ( 3, Size );
+		} else if ( Size < 32 ) {
+			Output.push_back ( static_cast<char> ( 0xA0 | Size ) );
+		} else if ( Size <= 0xFF ) {
+			Output.push_back ( static_cast<char> ( 0xD9 ) );
+			big<uint8_t> ( Size );
+		} else if ( Size <= 0xFFFF ) {
+			Output.push_back ( static_cast<char> ( 0xDA ) );
+			big<uint16_t> ( Size );
+		} else {
+			Output.push_back ( static_cast<char> ( 0xDB ) );
+			big<uint32_t> ( Size );
+		}
+	}
+
+	// UTF-16 units, or UTF-32 where wchar_t is 32 bits, to UTF-8. Lone surrogates and values past U+10FFFF
+	// become U+FFFD, so both passes agree on every length
+	void Binary::text ( std::wstring_view Value ) {
+		auto count = Value.size ();
+		auto point = [ & ] ( size_t& i ) {
+			uint32_t c = Value[ i ];
+			if ( c >= 0xD800 && c <= 0xDFFF ) {
+				if ( c <= 0xDBFF && i + 1 < count && ( Value[ i + 1 ] & 0xFC00 ) == 0xDC00 ) {
+					return 0x10000 + ( ( c - 0xD800 ) << 10 ) + ( static_cast<uint32_t> ( Value[ ++i ] ) - 0xDC00 );
+				}
+				return uint32_t { 0xFFFD };
+			}
+			return c > 0x10FFFF ? uint32_t { 0xFFFD } : c;
+		};
+		size_t size { 0 };
+		for ( size_t i = 0; i < count; ++i ) {
+			auto c = point ( i );
+			size += c < 0x80 ? 1 : c < 0x800 ? 2 : c < 0x10000 ? 3 : 4;
+		}
+		header ( size );
+		auto at = Output.size ();
+		Output.resize ( at + size );
+		auto out = reinterpret_cast<unsigned char*> ( Output.data () + at );
+		for ( size_t i = 0; i < count; ++i ) {
+			auto c = point ( i );
+			if ( c < 0x80 ) {
+				*out++ = static_cast<unsigned char> ( c );
+				continue;
+			}
+			if ( c < 0x800 ) {
+				*out++ = static_cast<unsigned char> ( 0xC0 | c >> 6 );
+			} else if ( c < 0x10000 ) {
+				*out++ = static_cast<unsigned char> ( 0xE0 | c >> 12 );
+				*out++ = static_cast<unsigned char> ( 0x80 | ( c >> 6 & 0x3F ) );
+			} else {
+				*out++ = static_cast<unsigned char> ( 0xF0 | c >> 18 );
+				*out++ = static_cast<unsigned char> ( 0x80 | ( c >> 12 & 0x3F ) );
+				*out++ = static_cast<unsigned char> ( 0x80 | ( c >> 6 & 0x3F ) );
+			}
+			*out++ = static_cast<unsigned char> ( 0x80 | ( c & 0x3F ) );
+		}
+	}
+
+	template <typename Integer>
+	void Binary::big ( Integer Value ) {
+		auto bits = static_cast<std::make_unsigned_t<Integer>> ( Value );
+		for ( auto shift = static_cast<int> ( sizeof bits * 8 ) - 8; shift >= 0; shift -= 8 ) {
+			Output.push_back ( static_cast<char> ( bits >> shift ) );
+		}
+	}
+
+	template class Writer<char>;
+	template class Writer<char16_t>;
+	template class Writer<wchar_t>;
+	template class Reader<char>;
+	template class Reader<char16_t>;
+	template class Reader<wchar_t>;
+	template bool unescape ( std::basic_string_view<char> Raw, std::wstring& Result );
+	template bool unescape ( std::basic_string_view<char16_t> Raw, std::wstring& Result );
+	template bool unescape ( std::basic_string_view<wchar_t> Raw, std::wstring& Result );
+	template bool parseStrings ( std::basic_string_view<wchar_t> Source, std::vector<std::wstring>& Result );
+	template bool parseList ( std::basic_string_view<wchar_t> Source, std::vector<std::wstring>& Items, bool& Json );
+#ifndef _WINDOWS
+	template class Writer<WCHAR_T>;
+	template class Reader<WCHAR_T>;
+	template bool unescape ( std::basic_string_view<WCHAR_T> Raw, std::wstring& Result );
+	template bool parseStrings ( std::basic_string_view<WCHAR_T> Source, std::vector<std::wstring>& Result );
+	template bool parseList ( std::basic_string_view<WCHAR_T> Source, std::vector<std::wstring>& Items, bool& Json );
+#endif
+}
@@ -1,13 +1,170 @@
 #ifndef __json_h__
 #define __json_h__
+#include <cstdint>
 #include <string>
 #include <memory>
+#include <memory_resource>
+#include <string_view>
 #include <vector>
 
 namespace JSON {
 	const char Hex[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
 	std::wstring toHex ( wchar_t Value );
 	void escape ( std::wstring* Result, const std::wstring& s );
+	template <typename Char>
+	bool parseStrings ( std::basic_string_view<Char> Source, std::vector<std::wstring>& Result );
+	template <typename Char>
+	bool parseList ( std::basic_string_view<Char> Source, std::vector<std::wstring>& Items, bool& Json );
+
+	enum class Token { BeginObject, EndObject, BeginArray, EndArray, Key, String, Number, True, False, Null, End, Error };
+
+	// Pull parser over text in any code unit type. It validates the grammar as it goes, but builds
+	// nothing: keys, strings and numbers are reported as raw views into the source, unescape decodes them
+	template <typename Char>
+	class Reader {
+	public:
+		using View = std::basic_string_view<Char>;
+
+		explicit Reader ( View Source );
+		Token Next ();
+		bool Skip ();
+
+		// Raw text of the last token, strings and keys without quotes
+		[[nodiscard]] View Value () const {
+			return Quoted ? Source.substr ( Start + 1, Finish - Start - 2 ) : Source.substr ( Start, Finish - Start );
+		}
+
+		// Source offsets where the last token starts and ends, after Skip the end is past the skipped value.
+		// After an error both point at the offending character
+		[[nodiscard]] size_t Position () const {
+			return Start;
+		}
+
+		[[nodiscard]] size_t Offset () const {
+			return Finish;
+		}
+
+		[[nodiscard]] View Text ( size_t From, size_t To ) const {
+			return Source.substr ( From, To - From );
+		}
+
+		[[nodiscard]] const char* Problem () const {
+			return Error;
+		}
+	private:
+		enum class Expect { Value, ValueOrEnd, Key, KeyOrEnd, CommaOrEnd, Done };
+		View Source;
+		size_t Current { 0 };
+		size_t Start { 0 };
+		size_t Finish { 0 };
+		bool Quoted { false };
+		Expect State { Expect::Value };
+		std::vector<char> Stack;
+		const char* Error { nullptr };
+
+		Token fail ( const char* Message );
+		void blank ();
+		void after ();
+		Token value ();
+		Token close ();
+		bool string ();
+		bool number ();
+		bool literal ( const char* Word );
+	};
+
+	template <typename Char>
+	bool unescape ( std::basic_string_view<Char> Raw, std::wstring& Result );
+
+	// Streaming writer appending straight into one growable buffer taken from Memory. Char selects the
+	// output encoding: char gives UTF-8, 16-bit types give UTF-16, wchar_t keeps code units as they come.
+	// Wide sources may hold UTF-16 code units, as strings from 1C do, or UTF-32 ones
+	template <typename Char>
+	class Writer {
+	public:
+		using Buffer = std::pmr::basic_string<Char>;
+
+		explicit Writer ( std::pmr::memory_resource* Memory = std::pmr::get_default_resource () ) : Output ( Memory ) {}
+
+		Writer& BeginObject ();
+		Writer& EndObject ();
+		Writer& BeginArray ();
+		Writer& EndArray ();
+		Writer& Key ( std::wstring_view Name );
+		Writer& String ( std::wstring_view Value );
+		Writer& String ( std::string_view Value );
+		Writer& Number ( int64_t Value );
+		Writer& Number ( double Value );
+		Writer& Bool ( bool Value );
+		Writer& Null ();
+		Writer& Raw ( std::basic_string_view<Char> Json );
+		void Clear ();
+
+		Buffer& Text () {
+			return Output;
+		}
+
+		[[nodiscard]] std::basic_string_view<Char> View () const {
+			return Output;
+		}
+	private:
+		Buffer Output;
+		bool Separate { false };
+
+		void next ();
+		void put ( char32_t Code );
+		void quote ( std::wstring_view Value );
+		template <typename Unit>
+		void widen ( const Unit* Data, size_t Size );
+	};
+
+	enum class Encoding { Text, CBOR, MessagePack };
+
+	// Picks the result encoding by the cbor or msgpack word in a format string
+	Encoding encoding ( std::wstring_view Format );
+
+	// The same streaming interface as Writer, producing CBOR or MessagePack. CBOR containers are
+	// indefinite-length, MessagePack ones get 32-bit headers which are filled in when they end
+	class Binary {
+	public:
+		explicit Binary ( Encoding Format, std::pmr::memory_resource* Memory = std::pmr::get_default_resource () );
+
+		Binary& BeginObject ();
+		Binary& EndObject ();
+		Binary& BeginArray ();
+		Binary& EndArray ();
+		Binary& Key ( std::wstring_view Name );
+		Binary& String ( std::wstring_view Value );
+		Binary& String ( std::string_view Value );
+		Binary& Number ( int64_t Value );
+		Binary& Number ( double Value );
+		Binary& Bool ( bool Value );
+		Binary& Null ();
+		Binary& Raw ( std::wstring_view Json );
+		void Clear ();
+
+		[[nodiscard]] std::string_view Data () const {
+			return Output;
+		}
+	private:
+		struct Level {
+			size_t Header;
+			uint32_t Count;
+			bool Map;
+		};
+
+		bool Cbor;
+		std::pmr::string Output;
+		std::pmr::vector<Level> Open;
+
+		void item ();
+		void begin ( bool Map );
+		void end ();
+		void head ( uint8_t Major, uint64_t Value );
+		void header ( size_t Size );
+		void text ( std::wstring_view Value );
+		template <typename Integer>
+		void big ( Integer Value );
+	};
 
 	class Value {
 	public:
@@ -30,7 +187,7 @@ namespace JSON {
 	class [[maybe_unused]] Number : public Value {
 	public:
 		using Value::Value;
-		[[maybe_unused]] void Set ( int Value );
+		void Set ( int64_t Value );
 		void Presentation ( std::wstring* Result ) override;
 	private:
 		std::wstring Storage;
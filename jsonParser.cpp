@@ -0,0 +1,634 @@
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <deque>
+#include <locale>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "jsonParser.h"
+#include "json.h"
+
+namespace {
+	using Source = Chars::View;
+
+	struct Step {
+		enum class Kind { Name, Index, Any } Type;
+		std::wstring Name;
+		size_t Index;
+	};
+
+	// A path and the source spans of the values it has reached
+	struct Path {
+		std::wstring Text;
+		std::vector<Step> Steps;
+		bool Wildcard { false };
+		std::vector<std::pair<size_t, size_t>> Found;
+	};
+
+	// Supports the JSONPath subset used to pick fields: $, .name, ['name'], [n], [*] and .*,
+	// the leading $ may be omitted
+	bool parsePath ( const std::wstring& Text, Path& Result ) {
+		Result.Text = Text;
+		size_t i { 0 };
+		auto size = Text.size ();
+		auto bare = size && Text[ 0 ] != '$' && Text[ 0 ] != '.' && Text[ 0 ] != '[';
+		if ( size && Text[ 0 ] == '$' ) {
+			++i;
+		}
+		while ( i < size ) {
+			auto c = Text[ i ];
+			if ( c == '.' || bare ) {
+				i += bare ? 0 : 1;
+				bare = false;
+				if ( i < size && Text[ i ] == '*' ) {
+					++i;
+					Result.Steps.push_back ( { Step::Kind::Any, {}, 0 } );
+					continue;
+				}
+				auto end = std::min ( Text.find_first_of ( L".[", i ), size );
+				if ( end == i ) {
+					return false;
+				}
+				Result.Steps.push_back ( { Step::Kind::Name, Text.substr ( i, end - i ), 0 } );
+				i = end;
+			} else if ( c == '[' ) {
+				++i;
+				if ( i < size && Text[ i ] == '*' ) {
+					++i;
+					Result.Steps.push_back ( { Step::Kind::Any, {}, 0 } );
+				} else if ( i < size && ( Text[ i ] == '\'' || Text[ i ] == '"' ) ) {
+					auto quote = Text[ i++ ];
+					auto end = Text.find ( quote, i );
+					if ( end == std::wstring::npos ) {
+						return false;
+					}
+					Result.Steps.push_back ( { Step::Kind::Name, Text.substr ( i, end - i ), 0 } );
+					i = end + 1;
+				} else {
+					size_t index { 0 };
+					auto from = i;
+					for ( ; i < size && Text[ i ] >= '0' && Text[ i ] <= '9'; ++i ) {
+						index = index * 10 + ( Text[ i ] - '0' );
+					}
+					if ( i == from ) {
+						return false;
+					}
+					Result.Steps.push_back ( { Step::Kind::Index, {}, index } );
+				}
+				if ( i == size || Text[ i ] != ']' ) {
+					return false;
+				}
+				++i;
+			} else {
+				return false;
+			}
+		}
+		Result.Wildcard = std::any_of ( Result.Steps.begin (), Result.Steps.end (), [] ( const Step& Item ) {
+			return Item.Type == Step::Kind::Any;
+		} );
+		return true;
+	}
+
+	// Walks the document with the pull parser, descending only into values some path can still reach
+	// and skipping the rest. Once every path without wildcards has its value, the rest is not read at all
+	class Extractor {
+	public:
+		Extractor ( Source Text, std::vector<Path>& Paths ) : Reader ( Text ), Paths ( Paths ) {
+			size_t depth { 0 };
+			for ( auto& path : Paths ) {
+				depth = std::max ( depth, path.Steps.size () );
+				Pending += path.Wildcard ? 0 : 1;
+				Wildcards |= path.Wildcard;
+			}
+			Levels.resize ( depth + 2 );
+			for ( size_t i = 0; i < Paths.size (); ++i ) {
+				Levels[ 0 ].push_back ( i );
+			}
+		}
+
+		bool Run () {
+			if ( !walk ( Reader.Next (), 0 ) ) {
+				return Stopped;
+			}
+			return Stopped || Reader.Next () == JSON::Token::End;
+		}
+
+		[[nodiscard]] const JSON::Reader<WCHAR_T>& Parser () const {
+			return Reader;
+		}
+	private:
+		JSON::Reader<WCHAR_T> Reader;
+		std::vector<Path>& Paths;
+		std::vector<std::vector<size_t>> Levels;
+		std::wstring Key;
+		size_t Pending { 0 };
+		bool Wildcards { false };
+		bool Stopped { false };
+
+		bool walk ( JSON::Token Token, size_t Depth ) {
+			if ( Token == JSON::Token::Error || Token == JSON::Token::End ) {
+				return false;
+			}
+			auto start = Reader.Position ();
+			auto& active = Levels[ Depth ];
+			auto& next = Levels[ Depth + 1 ];
+			auto deeper = std::any_of ( active.begin (), active.end (), [ & ] ( size_t Index ) {
+				return Paths[ Index ].Steps.size () > Depth;
+			} );
+			if ( Token == JSON::Token::BeginObject ) {
+				if ( !deeper ) {
+					if ( !Reader.Skip () ) {
+						return false;
+					}
+				} else {
+					for ( auto token = Reader.Next (); token != JSON::Token::EndObject; token = Reader.Next () ) {
+						if ( token != JSON::Token::Key ) {
+							return false;
+						}
+						auto key = Reader.Value ();
+						auto escaped = std::find ( key.begin (), key.end (), '\\' ) != key.end ();
+						if ( escaped ) {
+							Key.clear ();
+							JSON::unescape ( key, Key );
+						}
+						next.clear ();
+						for ( auto index : active ) {
+							auto& steps = Paths[ index ].Steps;
+							if ( steps.size () <= Depth ) {
+								continue;
+							}
+							auto& step = steps[ Depth ];
+							if ( step.Type == Step::Kind::Any
+								 || ( step.Type == Step::Kind::Name
+									  && ( escaped ? Key == step.Name
+												   : std::equal ( key.begin (), key.end (), step.Name.begin (), step.Name.end () ) ) ) ) {
+								next.push_back ( index );
+							}
+						}
+						if ( !child ( Depth ) ) {
+							return false;
+						}
+					}
+				}
+			} else if ( Token == JSON::Token::BeginArray ) {
+				if ( !deeper ) {
+					if ( !Reader.Skip () ) {
+						return false;
+					}
+				} else {
+					size_t item { 0 };
+					for ( ;; ++item ) {
+						next.clear ();
+						for ( auto index : active ) {
+							auto& steps = Paths[ index ].Steps;
+							if ( steps.size () > Depth && ( steps[ Depth ].Type == Step::Kind::Any
+															|| ( steps[ Depth ].Type == Step::Kind::Index && steps[ Depth ].Index == item ) ) ) {
+								next.push_back ( index );
+							}
+						}
+						auto token = Reader.Next ();
+						if ( token == JSON::Token::EndArray ) {
+							break;
+						}
+						if ( next.empty () ? !skip ( token ) : !walk ( token, Depth + 1 ) ) {
+							return false;
+						}
+					}
+				}
+			} else if ( Token == JSON::Token::EndObject || Token == JSON::Token::EndArray || Token == JSON::Token::Key ) {
+				return false;
+			}
+			for ( auto index : active ) {
+				auto& path = Paths[ index ];
+				if ( path.Steps.size () == Depth && ( path.Wildcard || path.Found.empty () ) ) {
+					path.Found.emplace_back ( start, Reader.Offset () );
+					Pending -= path.Wildcard ? 0 : 1;
+				}
+			}
+			if ( !Wildcards && !Pending ) {
+				Stopped = true;
+				return false;
+			}
+			return true;
+		}
+
+		// Reads the value of the current key, walking into it when some path goes on there
+		bool child ( size_t Depth ) {
+			auto token = Reader.Next ();
+			return Levels[ Depth + 1 ].empty () ? skip ( token ) : walk ( token, Depth + 1 );
+		}
+
+		bool skip ( JSON::Token Token ) {
+			switch ( Token ) {
+				case JSON::Token::BeginObject:
+				case JSON::Token::BeginArray:
+					return Reader.Skip ();
+				case JSON::Token::String:
+				case JSON::Token::Number:
+				case JSON::Token::True:
+				case JSON::Token::False:
+				case JSON::Token::Null:
+					return true;
+				default:
+					return false;
+			}
+		}
+	};
+
+	bool readPaths ( tVariant* Param, std::vector<Path>& Paths, std::wstring& Problem ) {
+		std::vector<std::wstring> list;
+		bool json;
+		if ( !JSON::parseList ( Chars::ToView ( Param ), list, json ) ) {
+			Problem = L"Paths should be a JSON array of strings or newline-delimited text";
+			return false;
+		}
+		Paths.reserve ( list.size () );
+		for ( auto& text : list ) {
+			if ( text.empty () && !json ) {
+				continue;
+			}
+			if ( !parsePath ( text, Paths.emplace_back () ) ) {
+				Problem = L"Invalid path: " + text;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::string describe ( const JSON::Reader<WCHAR_T>& Parser ) {
+		return std::string ( Parser.Problem () ? Parser.Problem () : "Unexpected end of data" ) + " at position "
+			   + std::to_string ( Parser.Position () + 1 );
+	}
+
+	// Flat document tree in preorder. Every node knows the size of its subtree, so the next sibling
+	// is a jump away, and keeps the source spans of its value and of its key in the parent object
+	struct Node {
+		JSON::Token Type;
+		size_t Start;
+		size_t Finish;
+		size_t KeyStart;
+		size_t KeyFinish;
+		size_t Size;
+	};
+
+	constexpr size_t MaxDepth { 1024 };
+
+	bool build ( Source Text, std::vector<Node>& Nodes, std::string& Problem ) {
+		JSON::Reader<WCHAR_T> reader ( Text );
+		Nodes.reserve ( Text.size () / 8 );
+		std::vector<size_t> open;
+		size_t keyStart { 0 };
+		size_t keyFinish { 0 };
+		for ( auto token = reader.Next (); token != JSON::Token::End; token = reader.Next () ) {
+			switch ( token ) {
+				case JSON::Token::Error:
+					Problem = describe ( reader );
+					return false;
+				case JSON::Token::Key:
+					keyStart = reader.Position () + 1;
+					keyFinish = reader.Offset () - 1;
+					break;
+				case JSON::Token::EndObject:
+				case JSON::Token::EndArray: {
+					auto& node = Nodes[ open.back () ];
+					node.Finish = reader.Offset ();
+					node.Size = Nodes.size () - open.back ();
+					open.pop_back ();
+					break;
+				}
+				default:
+					Nodes.push_back ( { token, reader.Position (), reader.Offset (), keyStart, keyFinish, 1 } );
+					if ( token == JSON::Token::BeginObject || token == JSON::Token::BeginArray ) {
+						if ( open.size () == MaxDepth ) {
+							Problem = "Document is nested too deep";
+							return false;
+						}
+						open.push_back ( Nodes.size () - 1 );
+					}
+			}
+		}
+		return true;
+	}
+
+	// Structural comparison: object keys in any order, numbers by value within Tolerance, strings
+	// after unescaping. Every difference is written as the path where it is found
+	class Comparison {
+	public:
+		Comparison ( Source Expected, Source Actual, double Tolerance, std::vector<Path>& Ignore,
+					 JSON::Writer<WCHAR_T>& Output ) : Tolerance ( Tolerance ), Ignore ( Ignore ), Output ( Output ) {
+			Sides[ 0 ].Text = Expected;
+			Sides[ 1 ].Text = Actual;
+			size_t depth { 0 };
+			for ( auto& path : Ignore ) {
+				depth = std::max ( depth, path.Steps.size () );
+			}
+			Levels.resize ( depth + 1 );
+			for ( size_t i = 0; i < Ignore.size (); ++i ) {
+				Levels[ 0 ].push_back ( i );
+			}
+		}
+
+		bool Run ( std::string& Problem ) {
+			if ( !build ( Sides[ 0 ].Text, Sides[ 0 ].Nodes, Problem ) ) {
+				Problem = "Expected: " + Problem;
+				return false;
+			}
+			if ( !build ( Sides[ 1 ].Text, Sides[ 1 ].Nodes, Problem ) ) {
+				Problem = "Actual: " + Problem;
+				return false;
+			}
+			Location = L"$";
+			compare ( 0, 0, 0 );
+			return true;
+		}
+	private:
+		using Key = std::basic_string_view<WCHAR_T>;
+
+		struct Side {
+			Source Text;
+			std::vector<Node> Nodes;
+		};
+
+		struct Member {
+			Key Name;
+			size_t Node;
+		};
+
+		double Tolerance;
+		std::vector<Path>& Ignore;
+		JSON::Writer<WCHAR_T>& Output;
+		Side Sides[ 2 ];
+		std::vector<std::vector<size_t>> Levels;
+		std::deque<std::pair<std::vector<Member>, std::vector<Member>>> Members;
+		std::deque<std::basic_string<WCHAR_T>> Decoded;
+		std::wstring Location;
+		std::wstring Left;
+		std::wstring Right;
+
+		static int kind ( JSON::Token Type ) {
+			return Type == JSON::Token::False ? static_cast<int> ( JSON::Token::True ) : static_cast<int> ( Type );
+		}
+
+		void differ () {
+			Output.String ( Location );
+		}
+
+		void compare ( size_t A, size_t B, size_t Depth ) {
+			if ( Depth < Levels.size () ) {
+				for ( auto index : Levels[ Depth ] ) {
+					if ( Ignore[ index ].Steps.size () == Depth ) {
+						return;
+					}
+				}
+			}
+			auto& a = Sides[ 0 ].Nodes[ A ];
+			auto& b = Sides[ 1 ].Nodes[ B ];
+			if ( kind ( a.Type ) != kind ( b.Type ) ) {
+				return differ ();
+			}
+			switch ( a.Type ) {
+				case JSON::Token::BeginObject:
+					return objects ( A, B, Depth );
+				case JSON::Token::BeginArray:
+					return arrays ( A, B, Depth );
+				case JSON::Token::String:
+					return strings ( a, b ) ? void () : differ ();
+				case JSON::Token::Number:
+					return numbers ( a, b ) ? void () : differ ();
+				default:
+					return a.Type == b.Type ? void () : differ ();
+			}
+		}
+
+		void objects ( size_t A, size_t B, size_t Depth ) {
+			if ( Members.size () <= Depth ) {
+				Members.resize ( Depth + 1 );
+			}
+			auto& [ left, right ] = Members[ Depth ];
+			members ( Sides[ 0 ], A, left );
+			members ( Sides[ 1 ], B, right );
+			auto length = Location.size ();
+			size_t i { 0 };
+			size_t j { 0 };
+			while ( i < left.size () || j < right.size () ) {
+				auto order = i == left.size () ? 1 : j == right.size () ? -1 : left[ i ].Name.compare ( right[ j ].Name );
+				auto& name = order > 0 ? right[ j ].Name : left[ i ].Name;
+				append ( name );
+				if ( descend ( Depth, [ & ] ( const Step& Item ) {
+						return Item.Type == Step::Kind::Name && std::equal ( name.begin (), name.end (), Item.Name.begin (), Item.Name.end () );
+					} ) ) {
+					if ( order ) {
+						differ ();
+					} else {
+						compare ( left[ i ].Node, right[ j ].Node, Depth + 1 );
+					}
+				}
+				Location.resize ( length );
+				i += order <= 0 ? 1 : 0;
+				j += order >= 0 ? 1 : 0;
+			}
+		}
+
+		void arrays ( size_t A, size_t B, size_t Depth ) {
+			auto& left = Sides[ 0 ].Nodes;
+			auto& right = Sides[ 1 ].Nodes;
+			auto length = Location.size ();
+			auto a = A + 1;
+			auto b = B + 1;
+			auto endA = A + left[ A ].Size;
+			auto endB = B + right[ B ].Size;
+			for ( size_t index = 0; a < endA || b < endB; ++index ) {
+				char digits[ 24 ];
+				auto end = std::to_chars ( digits, digits + sizeof digits, index ).ptr;
+				Location.push_back ( '[' );
+				Location.append ( digits, end );
+				Location.push_back ( ']' );
+				if ( descend ( Depth, [ & ] ( const Step& Item ) {
+						return Item.Type == Step::Kind::Index && Item.Index == index;
+					} ) ) {
+					if ( a < endA && b < endB ) {
+						compare ( a, b, Depth + 1 );
+					} else {
+						differ ();
+					}
+				}
+				Location.resize ( length );
+				a = a < endA ? a + left[ a ].Size : a;
+				b = b < endB ? b + right[ b ].Size : b;
+			}
+		}
+
+		// Prepares the ignore paths which go on below the member, false when one of them ends on it
+		template <typename Match>
+		bool descend ( size_t Depth, const Match& Matches ) {
+			if ( Depth + 1 >= Levels.size () ) {
+				return true;
+			}
+			auto& next = Levels[ Depth + 1 ];
+			next.clear ();
+			for ( auto index : Levels[ Depth ] ) {
+				auto& steps = Ignore[ index ].Steps;
+				if ( steps.size () > Depth && ( steps[ Depth ].Type == Step::Kind::Any || Matches ( steps[ Depth ] ) ) ) {
+					if ( steps.size () == Depth + 1 ) {
+						return false;
+					}
+					next.push_back ( index );
+				}
+			}
+			return true;
+		}
+
+		// Object members sorted by key, keys with escapes are decoded first
+		void members ( const Side& Document, size_t Object, std::vector<Member>& Result ) {
+			Result.clear ();
+			auto end = Object + Document.Nodes[ Object ].Size;
+			for ( auto i = Object + 1; i < end; i += Document.Nodes[ i ].Size ) {
+				auto& node = Document.Nodes[ i ];
+				auto name = Document.Text.substr ( node.KeyStart, node.KeyFinish - node.KeyStart );
+				if ( std::find ( name.begin (), name.end (), '\\' ) != name.end () ) {
+					Left.clear ();
+					JSON::unescape ( name, Left );
+					name = Decoded.emplace_back ( Left.begin (), Left.end () );
+				}
+				Result.push_back ( { name, i } );
+			}
+			std::sort ( Result.begin (), Result.end (), [] ( const Member& First, const Member& Second ) {
+				auto order = First.Name.compare ( Second.Name );
+				return order < 0 || ( !order && First.Node < Second.Node );
+			} );
+		}
+
+		void append ( Key Name ) {
+			auto plain = !Name.empty () && std::none_of ( Name.begin (), Name.end (), [] ( WCHAR_T c ) {
+				return c == '.' || c == '[' || c == ']' || c == '\'' || c == '"' || c == ' ';
+			} );
+			Location.append ( plain ? L"." : L"['" );
+			Location.append ( Name.begin (), Name.end () );
+			if ( !plain ) {
+				Location.append ( L"']" );
+			}
+		}
+
+		[[nodiscard]] Key raw ( int Side, const Node& Value ) const {
+			return Sides[ Side ].Text.substr ( Value.Start, Value.Finish - Value.Start );
+		}
+
+		bool strings ( const Node& A, const Node& B ) {
+			auto a = raw ( 0, A );
+			auto b = raw ( 1, B );
+			if ( a == b ) {
+				return true;
+			}
+			if ( std::find ( a.begin (), a.end (), '\\' ) == a.end () && std::find ( b.begin (), b.end (), '\\' ) == b.end () ) {
+				return false;
+			}
+			Left.clear ();
+			Right.clear ();
+			JSON::unescape ( a.substr ( 1, a.size () - 2 ), Left );
+			JSON::unescape ( b.substr ( 1, b.size () - 2 ), Right );
+			return Left == Right;
+		}
+
+		bool numbers ( const Node& A, const Node& B ) {
+			auto a = raw ( 0, A );
+			auto b = raw ( 1, B );
+			return a == b || std::fabs ( toDouble ( a ) - toDouble ( b ) ) <= Tolerance;
+		}
+
+		// Numbers are already validated by the reader, the classic locale keeps the decimal point
+		static double toDouble ( Key Text ) {
+			std::istringstream stream ( std::string ( Text.begin (), Text.end () ) );
+			stream.imbue ( std::locale::classic () );
+			double result { 0 };
+			stream >> result;
+			return result;
+		}
+	};
+}
+
+JSONParser::JSONParser () : Extender ( L"JSONParser", listMethods () ) {}
+
+JSONParser::~JSONParser () {
+	drain ();
+}
+
+Extender::Methods JSONParser::listMethods () {
+	static constexpr auto list = table (
+			concurrent ( function<&JSONParser::extract> ( L"Extract", L"Извлечь", 3, 1 ) ),
+			concurrent ( function<&JSONParser::compare> ( L"Compare", L"Сравнить", 4, 2 ) ) );
+	return list;
+}
+
+// Returns an object keyed by path text. A path without wildcards gets its value as is or null,
+// a path with wildcards gets an array of all values it matches in document order. Optional Format
+// cbor or msgpack returns the object as a binary value
+bool JSONParser::extract ( tVariant* Params, tVariant* Result ) {
+	std::vector<Path> paths;
+	std::wstring problem;
+	if ( !readPaths ( Params + 1, paths, problem ) ) {
+		SetError ( problem );
+		return false;
+	}
+	Extractor extractor ( Chars::ToView ( Params ), paths );
+	if ( !extractor.Run () ) {
+		SetError ( describe ( extractor.Parser () ) );
+		return false;
+	}
+	auto format = Params[ 2 ].vt == VTYPE_PWSTR ? JSON::encoding ( Chars::WCHARToWide ( Params[ 2 ].pwstrVal, Params[ 2 ].wstrLen ) )
+											  : JSON::Encoding::Text;
+	returnStructure ( Result, format, [ & ] ( auto& json ) {
+		std::wstring buffer;
+		auto raw = [ & ] ( const std::pair<size_t, size_t>& Span ) {
+			Chars::View value { Params->pwstrVal + Span.first, Span.second - Span.first };
+			if constexpr ( std::is_same_v<std::decay_t<decltype ( json )>, JSON::Binary> ) {
+				json.Raw ( Chars::Widen ( value, buffer ) );
+			} else {
+				json.Raw ( value );
+			}
+		};
+		json.BeginObject ();
+		for ( auto& path : paths ) {
+			json.Key ( path.Text );
+			if ( path.Wildcard ) {
+				json.BeginArray ();
+				std::for_each ( path.Found.begin (), path.Found.end (), raw );
+				json.EndArray ();
+			} else if ( path.Found.empty () ) {
+				json.Null ();
+			} else {
+				raw ( path.Found.front () );
+			}
+		}
+		json.EndObject ();
+	} );
+	return true;
+}
+
+// Returns the JSON array of paths where the documents differ, empty when they are equal.
+// Optional Tolerance is the allowed absolute difference of numbers, Ignore lists paths to skip,
+// wildcards included
+bool JSONParser::compare ( tVariant* Params, tVariant* Result ) {
+	auto next = Params + 2;
+	auto tolerance = next->vt == VTYPE_EMPTY ? 0.0 : getNumber ( next );
+	++next;
+	std::vector<Path> ignore;
+	std::wstring problem;
+	if ( next->vt != VTYPE_EMPTY && !readPaths ( next, ignore, problem ) ) {
+		SetError ( problem );
+		return false;
+	}
+	JSON::Writer<WCHAR_T> result ( scratch () );
+	result.BeginArray ();
+	Comparison comparison ( Chars::ToView ( Params ), Chars::ToView ( Params + 1 ), tolerance, ignore, result );
+	std::string failure;
+	if ( !comparison.Run ( failure ) ) {
+		SetError ( failure );
+		return false;
+	}
+	result.EndArray ();
+	returnString ( Result, result.Text () );
+	return true;
+}
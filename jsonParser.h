@@ -0,0 +1,14 @@
+#ifndef __jsonParser_h__
+#define __jsonParser_h__
+#include "extender.h"
+
+class JSONParser : public Extender {
+public:
+	JSONParser ();
+	~JSONParser () override;
+private:
+	static Methods listMethods ();
+	bool extract ( tVariant* Params, tVariant* Result );
+	bool compare ( tVariant* Params, tVariant* Result );
+};
+#endif
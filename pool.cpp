@@ -0,0 +1,86 @@
+#include "pool.h"
+#include <algorithm>
+#include "trace.h"
+
+Pool::Pool ( size_t Threads, size_t Limit ) : Limit ( Limit ) {
+	for ( size_t i = 0; i < Threads; ++i ) {
+		Queues.push_back ( std::make_unique<Queue> () );
+	}
+	for ( size_t i = 0; i < Threads; ++i ) {
+		this->Threads.emplace_back ( &Pool::run, this, i );
+	}
+}
+
+// Tasks still queued are dropped, components wait for their own ones before they go
+Pool::~Pool () {
+	{
+		std::lock_guard<std::mutex> guard ( Sleep );
+		Stopping = true;
+	}
+	Wake.notify_all ();
+	for ( auto& thread : Threads ) {
+		thread.join ();
+	}
+}
+
+Pool& Pool::Shared () {
+	static Pool pool ( std::max ( 2u, std::thread::hardware_concurrency () ), 256 );
+	return pool;
+}
+
+bool Pool::Submit ( Task Job ) {
+	if ( Queued.fetch_add ( 1, std::memory_order_acq_rel ) >= Limit ) {
+		Queued.fetch_sub ( 1, std::memory_order_relaxed );
+		return false;
+	}
+	auto& queue = *Queues[ Next.fetch_add ( 1, std::memory_order_relaxed ) % Queues.size () ];
+	{
+		std::lock_guard<std::mutex> guard ( queue.Lock );
+		queue.Tasks.push_back ( std::move ( Job ) );
+	}
+	// Taking the lock orders the push before a worker that is about to sleep checks again
+	{
+		std::lock_guard<std::mutex> guard ( Sleep );
+	}
+	Wake.notify_one ();
+	return true;
+}
+
+void Pool::run ( size_t Index ) {
+	Tracer::Label ( "Async" );
+	Task job;
+	while ( true ) {
+		if ( take ( Index, job ) ) {
+			Queued.fetch_sub ( 1, std::memory_order_acq_rel );
+			job ();
+			job = nullptr;
+			continue;
+		}
+		std::unique_lock<std::mutex> lock ( Sleep );
+		if ( Stopping ) {
+			return;
+		}
+		Wake.wait ( lock, [ this ] {
+			return Stopping || Queued.load ( std::memory_order_acquire );
+		} );
+	}
+}
+
+bool Pool::take ( size_t Index, Task& Job ) {
+	for ( size_t i = 0; i < Queues.size (); ++i ) {
+		auto& queue = *Queues[ ( Index + i ) % Queues.size () ];
+		std::lock_guard<std::mutex> guard ( queue.Lock );
+		if ( queue.Tasks.empty () ) {
+			continue;
+		}
+		if ( !i ) {
+			Job = std::move ( queue.Tasks.front () );
+			queue.Tasks.pop_front ();
+		} else {
+			Job = std::move ( queue.Tasks.back () );
+			queue.Tasks.pop_back ();
+		}
+		return true;
+	}
+	return false;
+}
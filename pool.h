@@ -0,0 +1,50 @@
+#ifndef __pool_h__
+#define __pool_h__
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Threads shared by all components for methods called asynchronously. Each thread has its own queue,
+// takes from its front and, once it is empty, steals from the back of the others. Submit refuses work
+// when Limit tasks are already waiting, so a script that outpaces the pool gets an error instead of
+// an ever growing backlog
+class Pool {
+public:
+	using Task = std::function<void ()>;
+
+	Pool ( size_t Threads, size_t Limit );
+	~Pool ();
+	Pool ( const Pool& ) = delete;
+	Pool& operator= ( const Pool& ) = delete;
+
+	// One per process, started on first use
+	static Pool& Shared ();
+	[[nodiscard]] bool Submit ( Task Job );
+	[[nodiscard]] size_t Waiting () const {
+		return Queued.load ( std::memory_order_relaxed );
+	}
+private:
+	struct Queue {
+		std::mutex Lock;
+		std::deque<Task> Tasks;
+	};
+
+	std::vector<std::unique_ptr<Queue>> Queues;
+	std::vector<std::thread> Threads;
+	const size_t Limit;
+	std::atomic<size_t> Queued { 0 };
+	std::atomic<size_t> Next { 0 };
+	std::mutex Sleep;
+	std::condition_variable Wake;
+	bool Stopping { false };
+
+	void run ( size_t Index );
+	bool take ( size_t Index, Task& Job );
+};
+#endif
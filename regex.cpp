@@ -1,38 +1,328 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <filesystem>
 #include <regex>
+#include <thread>
+#include <type_traits>
+#include <vector>
 #include "regex.h"
 #include "json.h"
+#include "files.h"
 
-Regex::Regex () : Extender ( L"Regex" ) {
-	methods.AddFunction ( L"Select", L"Выбрать", 2, [ & ] ( tVariant* Params, tVariant* Result ) {
-		return select ( Params, Result );
-	} );
-	methods.AddFunction ( L"Test", L"Тест", 2, [ & ] ( tVariant* Params, tVariant* Result ) {
-		return test ( Params, Result );
-	} );
-	methods.AddFunction ( L"Replace", L"Заменить", 3, [ & ] ( tVariant* Params, tVariant* Result ) {
-		return replace ( Params, Result );
-	} );
+namespace {
+	// SelectFile decodes the mapped file by windows of Chunk bytes plus Overlap bytes of lookahead,
+	// so matches up to Overlap bytes long are found even when they cross the chunk boundary
+	constexpr size_t Chunk { 1 << 20 };
+	constexpr size_t Overlap { 1 << 16 };
+
+	struct Found {
+		size_t Offset;
+		std::wstring Value;
+		std::vector<std::wstring> Groups;
+	};
+
+	size_t align ( const char* Data, size_t Position, size_t Size ) {
+		while ( Position < Size && Position && ( static_cast<unsigned char> ( Data[ Position ] ) & 0xC0 ) == 0x80 ) {
+			--Position;
+		}
+		return Position;
+	}
+
+	// UTF-8 to UTF-16 code units, as 1C strings have them, remembering the byte offset of every unit.
+	// Malformed sequences are replaced by U+FFFD, one per byte
+	void decode ( const char* Data, size_t From, size_t To, std::wstring& Text, std::vector<size_t>& Offsets ) {
+		Text.clear ();
+		Offsets.clear ();
+		auto bytes = reinterpret_cast<const unsigned char*> ( Data );
+		auto i = From;
+		while ( i < To ) {
+			auto start = i;
+			uint32_t code = bytes[ i++ ];
+			if ( code >= 0x80 ) {
+				int extra = ( code & 0xE0 ) == 0xC0 ? 1 : ( code & 0xF0 ) == 0xE0 ? 2 : ( code & 0xF8 ) == 0xF0 ? 3 : 0;
+				code &= 0x3F >> extra;
+				for ( auto n = extra; n && i < To && ( bytes[ i ] & 0xC0 ) == 0x80; --n ) {
+					code = ( code << 6 ) | ( bytes[ i++ ] & 0x3F );
+				}
+				auto valid = extra && i - start == static_cast<size_t> ( extra + 1 )
+							 && code >= ( extra == 1 ? 0x80u : extra == 2 ? 0x800u : 0x10000u )
+							 && code <= 0x10FFFF && ( code < 0xD800 || code > 0xDFFF );
+				if ( !valid ) {
+					code = 0xFFFD;
+					i = start + 1;
+				}
+			}
+			if ( code > 0xFFFF ) {
+				code -= 0x10000;
+				Text.push_back ( static_cast<wchar_t> ( 0xD800 + ( code >> 10 ) ) );
+				Offsets.push_back ( start );
+				code = 0xDC00 + ( code & 0x3FF );
+			}
+			Text.push_back ( static_cast<wchar_t> ( code ) );
+			Offsets.push_back ( start );
+		}
+	}
+
+	// Runs Job for every index below Count, handing out Block indexes at a time to Threads threads,
+	// as many as the hardware has for zero
+	template <typename Job>
+	void forEach ( size_t Count, size_t Block, size_t Threads, const Job& Run ) {
+		std::atomic<size_t> current { 0 };
+		std::exception_ptr failure;
+		std::atomic_flag failed = ATOMIC_FLAG_INIT;
+		auto worker = [ & ] () {
+			try {
+				for ( size_t from; ( from = current.fetch_add ( Block ) ) < Count; ) {
+					for ( auto i = from, to = std::min ( Count, from + Block ); i < to; ++i ) {
+						Run ( i );
+					}
+				}
+			} catch ( ... ) {
+				if ( !failed.test_and_set () ) {
+					failure = std::current_exception ();
+				}
+				current = Count;
+			}
+		};
+		auto blocks = ( Count + Block - 1 ) / Block;
+		auto threads = std::min<size_t> ( blocks, Threads ? Threads : std::max ( 1u, std::thread::hardware_concurrency () ) );
+		std::vector<std::thread> pool;
+		for ( size_t i = 1; i < threads; ++i ) {
+			pool.emplace_back ( worker );
+		}
+		worker ();
+		for ( auto& thread : pool ) {
+			thread.join ();
+		}
+		if ( failure ) {
+			std::rethrow_exception ( failure );
+		}
+	}
+
+	// Arguments widened for code that needs wchar_t text, kept per thread so their capacity is reused
+	struct Arguments {
+		std::wstring Text;
+		std::wstring Query;
+		std::wstring Replacement;
+	};
+
+	Arguments& arguments () {
+		thread_local Arguments buffers;
+		return buffers;
+	}
+
+	bool isTrue ( tVariant* Param ) {
+		return Param->vt == VTYPE_BOOL && Param->bVal;
+	}
+
+	constexpr size_t BatchBlock { 256 };
+
+	// Select output. Full form is [{"Value":"","Groups":[""]}], offsets form replaces every string
+	// by its 1-based position and length in the source, tsv form puts a match per line and fields by tabs.
+	// Output is the text writer or the binary one, tsv is only available as text
+	template <typename Output>
+	struct Page {
+		static constexpr bool Textual { !std::is_same_v<Output, JSON::Binary> };
+		std::wstring_view Source;
+		bool Offsets;
+		bool Tsv;
+		Output& Json;
+		bool First { true };
+
+		void Begin () {
+			if ( !Textual || !Tsv ) {
+				Json.BeginArray ();
+			}
+		}
+
+		void End () {
+			if ( !Textual || !Tsv ) {
+				Json.EndArray ();
+			}
+		}
+
+		void Add ( const std::wcmatch& Match ) {
+			if constexpr ( Textual ) {
+				if ( Tsv ) {
+					tsv ( Match );
+					return;
+				}
+			}
+			if ( Offsets ) {
+				Json.BeginArray ();
+				for ( size_t i = 0; i < Match.size (); ++i ) {
+					auto matched = Match[ i ].matched;
+					Json.Number ( static_cast<int64_t> ( matched ? Match.position ( i ) + 1 : 0 ) );
+					Json.Number ( static_cast<int64_t> ( matched ? Match.length ( i ) : 0 ) );
+				}
+				Json.EndArray ();
+			} else {
+				Json.BeginObject ().Key ( L"Value" ).String ( view ( Match[ 0 ] ) ).Key ( L"Groups" ).BeginArray ();
+				for ( size_t i = 1; i < Match.size (); ++i ) {
+					Json.String ( view ( Match[ i ] ) );
+				}
+				Json.EndArray ().EndObject ();
+			}
+		}
+
+		void tsv ( const std::wcmatch& Match ) {
+			auto& text = Json.Text ();
+			if ( !First ) {
+				text.push_back ( '\n' );
+			}
+			First = false;
+			for ( size_t i = 0; i < Match.size (); ++i ) {
+				if ( i ) {
+					text.push_back ( '\t' );
+				}
+				if ( Offsets ) {
+					auto matched = Match[ i ].matched;
+					append ( std::to_wstring ( matched ? Match.position ( i ) + 1 : 0 ) );
+					text.push_back ( '\t' );
+					append ( std::to_wstring ( matched ? Match.length ( i ) : 0 ) );
+				} else {
+					field ( view ( Match[ i ] ) );
+				}
+			}
+		}
+
+		static std::wstring_view view ( const std::wcsub_match& Group ) {
+			if ( !Group.matched ) {
+				return {};
+			}
+			return { Group.first, static_cast<size_t> ( Group.length () ) };
+		}
+
+		void field ( std::wstring_view Value ) {
+			auto& text = Json.Text ();
+			for ( auto c : Value ) {
+				switch ( c ) {
+					case '\t':
+						append ( L"\\t" );
+						break;
+					case '\n':
+						append ( L"\\n" );
+						break;
+					case '\r':
+						append ( L"\\r" );
+						break;
+					case '\\':
+						append ( L"\\\\" );
+						break;
+					default:
+						text.push_back ( c );
+				}
+			}
+		}
+
+		// The text writer keeps 1C units, which are not wchar_t on Linux
+		void append ( std::wstring_view Value ) {
+			auto& text = Json.Text ();
+			text.append ( Value.begin (), Value.end () );
+		}
+	};
+
+	std::vector<Found> scan ( const std::filesystem::path& File, const std::wregex& Pattern, size_t Limit ) {
+		files::Mapping file ( File );
+		auto data = file.data ();
+		auto size = file.size ();
+		std::vector<Found> result;
+		std::wstring text;
+		std::vector<size_t> offsets;
+		size_t position { 0 };
+		while ( position < size ) {
+			auto end = align ( data, std::min ( size, position + Chunk + Overlap ), size );
+			auto boundary = align ( data, std::min ( size, position + Chunk ), size );
+			auto last = end == size;
+			decode ( data, position, end, text, offsets );
+			offsets.push_back ( end );
+			auto flags = std::regex_constants::match_default;
+			if ( position ) {
+				flags |= std::regex_constants::match_not_bol;
+			}
+			if ( !last ) {
+				flags |= std::regex_constants::match_not_eol;
+			}
+			auto next = std::max ( boundary, position + 1 );
+			for ( std::wsregex_iterator it ( text.cbegin (), text.cend (), Pattern, flags ), finish; it != finish; ++it ) {
+				auto& match = *it;
+				auto start = offsets[ match.position () ];
+				if ( !last && start >= boundary ) {
+					break;
+				}
+				Found item { start, match.str ( 0 ), {} };
+				for ( size_t i = 1; i < match.size (); ++i ) {
+					item.Groups.push_back ( match.str ( i ) );
+				}
+				result.push_back ( std::move ( item ) );
+				next = std::max ( next, offsets[ match.position () + match.length () ] );
+				if ( Limit && result.size () >= Limit ) {
+					return result;
+				}
+			}
+			file.release ( position, next - position );
+			position = next;
+		}
+		return result;
+	}
+}
+
+Regex::Regex () : Extender ( L"Regex", listMethods (), listProperties () ) {}
+
+Regex::~Regex () {
+	drain ();
+}
+
+Extender::Methods Regex::listMethods () {
+	static constexpr auto list = table (
+			concurrent ( function<&Regex::select> ( L"Select", L"Выбрать", 5, 3 ) ),
+			concurrent ( function<&Regex::selectFile> ( L"SelectFile", L"ВыбратьИзФайла", 4, 2 ) ),
+			concurrent ( function<&Regex::test> ( L"Test", L"Тест", 2 ) ),
+			concurrent ( function<&Regex::replace> ( L"Replace", L"Заменить", 3 ) ),
+			concurrent ( function<&Regex::testBatch> ( L"TestBatch", L"ТестПакет", 3, 1 ) ),
+			concurrent ( function<&Regex::replaceBatch> ( L"ReplaceBatch", L"ЗаменитьПакет", 4, 1 ) ) );
+	return list;
+}
+
+Extender::Properties Regex::listProperties () {
+	static constexpr auto list = fields ( number<&Regex::Threads, 0, 256> ( L"Threads", L"Потоки" ) );
+	return list;
 }
 
 bool Regex::select ( tVariant* Params, tVariant* Result ) {
-	std::wstring string { Chars::WCHARToWide ( Params->pwstrVal, Params->wstrLen ) };
+	auto& buffers = arguments ();
+	auto string = Chars::Widen ( Chars::ToView ( Params ), buffers.Text );
 	auto next = Params + 1;
-	std::wstring query = Chars::WCHARToWide ( next->pwstrVal, next->wstrLen );
-	std::wsmatch match;
-	using namespace JSON;
-	Array json;
-	std::wstring::const_iterator begin ( string.cbegin () );
+	auto query = Chars::Widen ( Chars::ToView ( next ), buffers.Query );
+	++next;
+	size_t offset = next->vt == VTYPE_EMPTY ? 0 : static_cast<size_t> ( getNumber ( next ) );
+	++next;
+	size_t limit = next->vt == VTYPE_EMPTY ? 0 : static_cast<size_t> ( getNumber ( next ) );
+	++next;
+	std::wstring format;
+	if ( next->vt == VTYPE_PWSTR ) {
+		format = Chars::WCHARToWide ( next->pwstrVal, next->wstrLen );
+	}
+	auto offsets = format.find ( L"offsets" ) != std::wstring::npos;
+	auto tsv = format.find ( L"tsv" ) != std::wstring::npos;
 	try {
 		auto pattern { Init ( query ) };
-		while ( regex_search ( begin, string.cend (), match, pattern ) ) {
-			auto record = json.Add<Object> ();
-			record->Add<String> ( L"Value" )->Set ( match.str ( 0 ) );
-			auto subMatches = record->Add<Array> ( L"Groups" );
-			for ( size_t i = 1; i < match.size (); ++i ) {
-				subMatches->Add<String> ()->Set ( match.str ( i ) );
+		returnStructure ( Result, JSON::encoding ( format ), [ & ] ( auto& json ) {
+			Page<std::decay_t<decltype ( json )>> page { string, offsets, tsv, json };
+			size_t index { 0 };
+			page.Begin ();
+			for ( std::wcregex_iterator it ( string.data (), string.data () + string.size (), pattern ), end; it != end; ++it ) {
+				if ( index++ < offset ) {
+					continue;
+				}
+				if ( limit && index > offset + limit ) {
+					break;
+				}
+				page.Add ( *it );
 			}
-			begin = match.suffix ().first;
-		}
+			page.End ();
+		} );
 	} catch ( const std::exception& e ) {
 		SetError ( e.what () );
 		return false;
@@ -40,30 +330,89 @@ bool Regex::select ( tVariant* Params, tVariant* Result ) {
 		SetError ( "Unknown error occurred in std::regex_search" );
 		return false;
 	}
-	std::wstring result;
-	json.Presentation ( &result );
-	returnString ( Result, result );
 	return true;
 }
 
-std::wregex Regex::Init ( const std::wstring& Pattern ) {
+bool Regex::selectFile ( tVariant* Params, tVariant* Result ) {
+	namespace fs = std::filesystem;
+	auto path = fs::u8path ( Chars::WideToString ( Chars::WCHARToWide ( Params->pwstrVal, Params->wstrLen ) ) );
+	auto next = Params + 1;
+	auto& buffers = arguments ();
+	auto query = Chars::Widen ( Chars::ToView ( next ), buffers.Query );
+	++next;
+	size_t limit = next->vt == VTYPE_EMPTY ? 0 : static_cast<size_t> ( getNumber ( next ) );
+	++next;
+	auto format = next->vt == VTYPE_PWSTR ? JSON::encoding ( Chars::Widen ( Chars::ToView ( next ), buffers.Text ) )
+										  : JSON::Encoding::Text;
+	std::vector<fs::path> list;
+	std::wregex pattern;
+	try {
+		list = files::expand ( path );
+		pattern = Init ( query );
+	} catch ( const std::exception& e ) {
+		SetError ( e.what () );
+		return false;
+	}
+	std::vector<std::vector<Found>> found ( list.size () );
+	std::vector<std::string> errors ( list.size () );
+	forEach ( list.size (), 1, static_cast<size_t> ( Threads.load () ), [ & ] ( size_t i ) {
+		try {
+			found[ i ] = scan ( list[ i ], pattern, limit );
+		} catch ( const std::exception& e ) {
+			errors[ i ] = e.what ();
+		} catch ( ... ) {
+			errors[ i ] = "Unknown error occurred in std::regex_search";
+		}
+	} );
+	auto failure = std::find_if ( errors.begin (), errors.end (), [] ( auto& error ) { return !error.empty (); } );
+	if ( failure != errors.end () ) {
+		SetError ( *failure );
+		if ( list.size () == 1 ) {
+			return false;
+		}
+	}
+	returnStructure ( Result, format, [ & ] ( auto& json ) {
+		json.BeginArray ();
+		size_t total { 0 };
+		for ( size_t i = 0; i < list.size (); ++i ) {
+			auto file = Chars::StringToWide ( list[ i ].u8string () );
+			for ( auto& item : found[ i ] ) {
+				if ( limit && total == limit ) {
+					break;
+				}
+				++total;
+				json.BeginObject ();
+				json.Key ( L"File" ).String ( file );
+				json.Key ( L"Offset" ).Number ( static_cast<int64_t> ( item.Offset ) );
+				json.Key ( L"Value" ).String ( item.Value );
+				json.Key ( L"Groups" ).BeginArray ();
+				for ( auto& group : item.Groups ) {
+					json.String ( group );
+				}
+				json.EndArray ().EndObject ();
+			}
+		}
+		json.EndArray ();
+	} );
+	return true;
+}
+
+std::wregex Regex::Init ( std::wstring_view Pattern ) {
 	std::wregex object;
 	try {
 		object.imbue ( std::locale ( "ru_RU.UTF-8" ) );
 	} catch ( const std::exception& e ) {
 		// Will ignore that issue
 	}
-	object.assign ( Pattern, std::regex_constants::icase );
+	object.assign ( Pattern.begin (), Pattern.end (), std::regex_constants::icase );
 	return object;
 }
 
 bool Regex::test ( tVariant* Params, tVariant* Result ) {
-	std::wstring string { Chars::WCHARToWide ( Params->pwstrVal, Params->wstrLen ) };
-	auto next = Params + 1;
-	std::wstring query = Chars::WCHARToWide ( next->pwstrVal, next->wstrLen );
-	std::wsmatch match;
+	auto string = Chars::ToView ( Params );
+	auto query = Chars::Widen ( Chars::ToView ( Params + 1 ), arguments ().Query );
 	try {
-		returnBool ( Result, std::regex_search ( string, match, Init ( query ) ) );
+		returnBool ( Result, std::regex_search ( Chars::Begin ( string ), Chars::End ( string ), Init ( query ) ) );
 	} catch ( const std::exception& e ) {
 		SetError ( e.what () );
 		return false;
@@ -75,14 +424,91 @@ bool Regex::test ( tVariant* Params, tVariant* Result ) {
 }
 
 bool Regex::replace ( tVariant* Params, tVariant* Result ) {
-	std::wstring string { Chars::WCHARToWide ( Params->pwstrVal, Params->wstrLen ) };
+	auto& buffers = arguments ();
+	auto string = Chars::ToView ( Params );
+	auto query = Chars::Widen ( Chars::ToView ( Params + 1 ), buffers.Query );
+	auto replacement = Chars::ToView ( Params + 2 );
+	buffers.Replacement.assign ( replacement.begin (), replacement.end () );
+	try {
+		Text result ( scratch () );
+		std::regex_replace ( std::back_inserter ( result ), Chars::Begin ( string ), Chars::End ( string ), Init ( query ),
+							 buffers.Replacement );
+		returnString ( Result, result );
+	} catch ( const std::exception& e ) {
+		SetError ( e.what () );
+		return false;
+	} catch ( ... ) {
+		SetError ( "Unknown error occurred in std::regex_replace" );
+		return false;
+	}
+	return true;
+}
+
+bool Regex::testBatch ( tVariant* Params, tVariant* Result ) {
+	std::vector<std::wstring> inputs;
+	bool json;
+	if ( !JSON::parseList ( Chars::ToView ( Params ), inputs, json ) ) {
+		SetError ( "Inputs should be a JSON array of strings or newline-delimited text" );
+		return false;
+	}
+	auto next = Params + 1;
+	auto query = Chars::Widen ( Chars::ToView ( next ), arguments ().Query );
+	auto parallel = isTrue ( ++next );
+	std::vector<char> found ( inputs.size () );
+	try {
+		auto pattern { Init ( query ) };
+		auto check = [ & ] ( size_t i ) {
+			found[ i ] = std::regex_search ( inputs[ i ], pattern );
+		};
+		forEach ( inputs.size (), parallel ? BatchBlock : inputs.size () + 1, static_cast<size_t> ( Threads.load () ), check );
+	} catch ( const std::exception& e ) {
+		SetError ( e.what () );
+		return false;
+	} catch ( ... ) {
+		SetError ( "Unknown error occurred in std::regex_search" );
+		return false;
+	}
+	if ( json ) {
+		JSON::Writer<WCHAR_T> result ( scratch () );
+		result.BeginArray ();
+		for ( auto value : found ) {
+			result.Bool ( value );
+		}
+		result.EndArray ();
+		returnString ( Result, result.Text () );
+	} else {
+		Text result ( scratch () );
+		for ( size_t i = 0; i < found.size (); ++i ) {
+			if ( i ) {
+				result.push_back ( '\n' );
+			}
+			result.push_back ( found[ i ] ? '1' : '0' );
+		}
+		returnString ( Result, result );
+	}
+	return true;
+}
+
+bool Regex::replaceBatch ( tVariant* Params, tVariant* Result ) {
+	std::vector<std::wstring> inputs;
+	bool json;
+	if ( !JSON::parseList ( Chars::ToView ( Params ), inputs, json ) ) {
+		SetError ( "Inputs should be a JSON array of strings or newline-delimited text" );
+		return false;
+	}
+	auto& buffers = arguments ();
 	auto next = Params + 1;
-	std::wstring query = Chars::WCHARToWide ( next->pwstrVal, next->wstrLen );
+	auto query = Chars::Widen ( Chars::ToView ( next ), buffers.Query );
 	++next;
-	std::wstring replacement = Chars::WCHARToWide ( next->pwstrVal, next->wstrLen );
-	std::wsmatch match;
+	auto replacement = Chars::ToView ( next );
+	buffers.Replacement.assign ( replacement.begin (), replacement.end () );
+	auto parallel = isTrue ( ++next );
 	try {
-		returnString ( Result, std::regex_replace ( string, Init ( query ), replacement ) );
+		auto pattern { Init ( query ) };
+		auto change = [ & ] ( size_t i ) {
+			inputs[ i ] = std::regex_replace ( inputs[ i ], pattern, buffers.Replacement );
+		};
+		forEach ( inputs.size (), parallel ? BatchBlock : inputs.size () + 1, static_cast<size_t> ( Threads.load () ), change );
 	} catch ( const std::exception& e ) {
 		SetError ( e.what () );
 		return false;
@@ -90,5 +516,23 @@ bool Regex::replace ( tVariant* Params, tVariant* Result ) {
 		SetError ( "Unknown error occurred in std::regex_replace" );
 		return false;
 	}
+	if ( json ) {
+		JSON::Writer<WCHAR_T> result ( scratch () );
+		result.BeginArray ();
+		for ( auto& value : inputs ) {
+			result.String ( value );
+		}
+		result.EndArray ();
+		returnString ( Result, result.Text () );
+	} else {
+		Text result ( scratch () );
+		for ( size_t i = 0; i < inputs.size (); ++i ) {
+			if ( i ) {
+				result.push_back ( '\n' );
+			}
+			result.append ( inputs[ i ].begin (), inputs[ i ].end () );
+		}
+		returnString ( Result, result );
+	}
 	return true;
 }
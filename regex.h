@@ -1,14 +1,25 @@
 #ifndef __regex_h__
 #define __regex_h__
+#include <atomic>
+#include <regex>
 #include "extender.h"
 
 class Regex : public Extender {
 public:
 	Regex ();
-	static std::wregex Init ( const std::wstring& Pattern );
+	~Regex () override;
+	static std::wregex Init ( std::wstring_view Pattern );
 private:
+	// Threads of SelectFile and the parallel batches, zero for one per hardware thread
+	std::atomic<long> Threads { 0 };
+
+	static Methods listMethods ();
+	static Properties listProperties ();
 	bool select ( tVariant* Params, tVariant* Result );
+	bool selectFile ( tVariant* Params, tVariant* Result );
 	bool test ( tVariant* Params, tVariant* Result );
 	bool replace ( tVariant* Params, tVariant* Result );
+	bool testBatch ( tVariant* Params, tVariant* Result );
+	bool replaceBatch ( tVariant* Params, tVariant* Result );
 };
 #endif
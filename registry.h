@@ -0,0 +1,139 @@
+#ifndef __registry_h__
+#define __registry_h__
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Method and property tables built at compile time. Every entry has an English and a Russian name,
+// 1C looks them up ignoring case, so names are hashed folded to lower case, Cyrillic included,
+// and the seed is searched until all of them land in distinct slots. A lookup is then one hash,
+// one slot and one comparison, and the index 1C keeps afterwards is the entry position
+namespace registry {
+template <typename Unit>
+constexpr uint32_t fold ( Unit Code ) {
+	auto code = static_cast<uint32_t> ( Code );
+	if ( ( code >= 'A' && code <= 'Z' ) || ( code >= 0x410 && code <= 0x42F ) ) {
+		return code + 0x20;
+	}
+	if ( code >= 0x400 && code <= 0x40F ) {
+		return code + 0x50;
+	}
+	return code;
+}
+
+template <typename Unit>
+constexpr uint32_t hash ( std::basic_string_view<Unit> Name, uint32_t Seed ) {
+	uint32_t result { 2166136261u ^ Seed * 0x9E3779B9u };
+	for ( auto code : Name ) {
+		result = ( result ^ fold ( code ) ) * 16777619u;
+	}
+	result ^= result >> 15;
+	result *= 0x2C1B3C6Du;
+	return result ^ result >> 12;
+}
+
+template <typename Left, typename Right>
+constexpr bool same ( std::basic_string_view<Left> First, std::basic_string_view<Right> Second ) {
+	if ( First.size () != Second.size () ) {
+		return false;
+	}
+	for ( size_t i = 0; i < First.size (); ++i ) {
+		if ( fold ( First[ i ] ) != fold ( Second[ i ] ) ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Slots for Count entries, eight per entry keeps the seed search short
+constexpr size_t capacity ( size_t Count ) {
+	size_t size { 1 };
+	while ( size < Count * 8 ) {
+		size <<= 1;
+	}
+	return size;
+}
+
+// What Extender keeps of a table: entries in declaration order and the slots to find them by name
+template <typename Entry>
+class Registry {
+public:
+	constexpr Registry () = default;
+
+	constexpr Registry ( const Entry* Items, size_t Count, const int16_t* Slots, size_t Mask, uint32_t Seed )
+			: Items ( Items ), Count ( Count ), Slots ( Slots ), Mask ( Mask ), Seed ( Seed ) {}
+
+	[[nodiscard]] constexpr size_t Size () const {
+		return Count;
+	}
+
+	[[nodiscard]] constexpr const Entry* Get ( long Index ) const {
+		return Index >= 0 && static_cast<size_t> ( Index ) < Count ? Items + Index : nullptr;
+	}
+
+	template <typename Unit>
+	[[nodiscard]] constexpr long Find ( std::basic_string_view<Unit> Name ) const {
+		if ( !Count ) {
+			return -1;
+		}
+		auto index = Slots[ hash ( Name, Seed ) & Mask ];
+		if ( index < 0 ) {
+			return -1;
+		}
+		auto& item = Items[ index ];
+		return same ( item.English, Name ) || same ( item.Russian, Name ) ? index : -1;
+	}
+private:
+	const Entry* Items { nullptr };
+	size_t Count { 0 };
+	const int16_t* Slots { nullptr };
+	size_t Mask { 0 };
+	uint32_t Seed { 0 };
+};
+
+template <typename Entry, size_t Count>
+class Table {
+public:
+	static constexpr size_t Size { capacity ( Count ) };
+
+	constexpr explicit Table ( const std::array<Entry, Count>& Items ) : Items ( Items ) {
+		for ( size_t i = 0; i < Count; ++i ) {
+			for ( size_t j = 0; j < i; ++j ) {
+				if ( same ( Items[ i ].English, Items[ j ].English ) || same ( Items[ i ].Russian, Items[ j ].Russian )
+					 || same ( Items[ i ].English, Items[ j ].Russian ) || same ( Items[ i ].Russian, Items[ j ].English ) ) {
+					throw "duplicate name";
+				}
+			}
+		}
+		while ( !place () ) {
+			++Seed;
+		}
+	}
+
+	constexpr operator Registry<Entry> () const {
+		return { Items.data (), Count, Slots.data (), Size - 1, Seed };
+	}
+private:
+	std::array<Entry, Count> Items;
+	std::array<int16_t, Size> Slots {};
+	uint32_t Seed { 0 };
+
+	constexpr bool place () {
+		for ( auto& slot : Slots ) {
+			slot = -1;
+		}
+		for ( size_t i = 0; i < Count; ++i ) {
+			for ( auto name : { Items[ i ].English, Items[ i ].Russian } ) {
+				auto& slot = Slots[ hash ( name, Seed ) & ( Size - 1 ) ];
+				if ( slot >= 0 && slot != static_cast<int16_t> ( i ) ) {
+					return false;
+				}
+				slot = static_cast<int16_t> ( i );
+			}
+		}
+		return true;
+	}
+};
+}
+#endif
@@ -7,33 +7,29 @@
 #include <cctype>
 #endif
 
-Root::Root () : Extender ( L"Root" ) {
-	methods.AddFunction ( L"Shoot", L"Снять", 2, [ & ] ( tVariant* Params, tVariant* Result ) {
-		return shoot ( Params, Result );
-	} );
-	methods.AddProcedure ( L"Maximize", L"Максимизировать", 1, [ & ] ( tVariant* Params ) {
-		return maximize ( Params );
-	} );
-	methods.AddProcedure ( L"Minimize", L"Минимизировать", 1, [ & ] ( tVariant* Params ) {
-		return minimize ( Params );
-	} );
-	methods.AddProcedure ( L"Pause", L"Пауза", 1, [ & ] ( tVariant* Params ) {
-		pause ( Params );
-		return true;
-	} );
-	methods.AddProcedure ( L"GotoConsole", L"ПерейтиВКонсоль", 0, [ & ] ( tVariant* Params ) {
-		gotoConsole ( Params );
-		return true;
-	} );
-	methods.AddFunction ( L"GetEnv", L"ПеременнаяСреды", 1, [ & ] ( tVariant* Params, tVariant* Result ) {
-		getEnvironment ( Params, Result );
-		return true;
-	} );
+Root::Root () : Extender ( L"Root", listMethods (), listProperties () ) {}
+
+Extender::Methods Root::listMethods () {
+	static constexpr auto list = table (
+			function<&Root::shoot> ( L"Shoot", L"Снять", 2 ),
+			procedure<&Root::maximize> ( L"Maximize", L"Максимизировать", 1 ),
+			procedure<&Root::minimize> ( L"Minimize", L"Минимизировать", 1 ),
+			procedure<&Root::pause> ( L"Pause", L"Пауза", 1 ),
+			procedure<&Root::gotoConsole> ( L"GotoConsole", L"ПерейтиВКонсоль", 0 ),
+			function<&Root::getEnvironment> ( L"GetEnv", L"ПеременнаяСреды", 1 ) );
+	return list;
+}
+
+Extender::Properties Root::listProperties () {
+	static constexpr auto list = fields (
+			number<&Root::ActivationWait, 0, 60000> ( L"ActivationWait", L"ОжиданиеАктивации" ),
+			number<&Root::PngLevel, -1, 9> ( L"PngLevel", L"СжатиеPng" ) );
+	return list;
 }
 
 bool Root::shoot ( tVariant* Params, tVariant* Result ) {
 #if __linux__
-	Shooter screenshot;
+	Shooter screenshot ( ActivationWait, static_cast<int> ( PngLevel.load () ) );
 	std::optional<Shooter::RawBuffer> result;
 	try {
 		result = screenshot.Take ( Chars::WCHARToWide ( Params->pwstrVal ) );
@@ -72,16 +68,7 @@ bool Root::shoot ( tVariant* Params, tVariant* Result ) {
 
 #if __linux__
 void Root::getPicture ( Shooter::RawBuffer& Buffer, tVariant* Result ) const {
-	auto size = Buffer.Size;
-	auto source = Buffer.Buffer;
-	if ( memoryManager->AllocMemory ( reinterpret_cast<void**>( &Result->pstrVal ), size ) ) {
-		auto destination = Result->pstrVal;
-		Result->strLen = size;
-		Result->vt = VTYPE_BLOB;
-		while ( size-- ) {
-			*destination++ = *source++;
-		}
-	}
+	returnBlob ( Result, { Buffer.Buffer, Buffer.Size } );
 }
 #elif _WIN32
 void Root::getPicture ( IStream* Image, tVariant* Result ) const {
@@ -89,7 +76,7 @@ void Root::getPicture ( IStream* Image, tVariant* Result ) const {
 	auto result = Image->Stat ( &info, STATFLAG_NONAME );
 	if ( result != S_OK ) return;
 	auto& size = info.cbSize.QuadPart;
-	if ( size && memoryManager->AllocMemory ( reinterpret_cast<void**>( &Result->pstrVal ), size ) ) {
+	if ( size && memory ()->AllocMemory ( reinterpret_cast<void**>( &Result->pstrVal ), size ) ) {
 		ULONG copied;
 		result = Image->Read ( Result->pstrVal, size, &copied );
 		if ( result == S_OK ) {
@@ -1,5 +1,6 @@
 #ifndef __root_h__
 #define __root_h__
+#include <atomic>
 #include "extender.h"
 #include "shooter.h"
 
@@ -7,6 +8,13 @@ class Root : public Extender {
 public:
 	Root ();
 private:
+	// Used on Linux: how many milliseconds Shoot waits for the window to become active, and the zlib
+	// level of the picture, -1 for the libpng default
+	std::atomic<long> ActivationWait { 500 };
+	std::atomic<long> PngLevel { -1 };
+
+	static Methods listMethods ();
+	static Properties listProperties ();
 	bool shoot ( tVariant* Params, tVariant* Result );
 	bool maximize ( tVariant* Params );
 	bool minimize ( tVariant* Params );
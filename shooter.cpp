@@ -1,7 +1,7 @@
-#include "shooter.h"
+// Before X11 headers, which define True, False and Bool as macros
 #include "regex.h"
+#include "shooter.h"
 #if __linux__
-#include <codecvt>
 #include <unistd.h>
 #include <chrono>
 
@@ -41,7 +41,7 @@ Shooter::RawBuffer& Shooter::RawBuffer::operator= ( Shooter::RawBuffer&& Parent
 	return *this;
 }
 
-Shooter::Shooter () {
+Shooter::Shooter ( long Activation, int Level ) : WaitingActivation ( Activation ), Level ( Level ) {
 	Monitor = XOpenDisplay ( nullptr );
 	XSetErrorHandler ( errorHandler );
 }
@@ -77,22 +77,27 @@ std::optional<Shooter::RawBuffer> Shooter::Take ( const std::wstring& Title ) {
 		return std::nullopt;
 	}
 	XWindowAttributes attributes;
-	XImage* image;
+	XImage* image { nullptr };
 	auto frame = window.value ();
 	auto waiting = WaitingActivation;
-	while ( waiting ) {
+	while ( true ) {
 		activate ( frame );
 		try {
 			XGetWindowAttributes ( Monitor, frame, &attributes );
 			image = XGetImage ( Monitor, frame, 0, 0, attributes.width, attributes.height, AllPlanes, ZPixmap );
-			break;
 		} catch ( ... ) {
-			usleep ( WaitingPause );
-			waiting -= WaitingPause;
-			continue;
+			image = nullptr;
+		}
+		if ( image ) {
+			break;
+		}
+		if ( waiting <= 0 ) {
+			return std::nullopt;
 		}
+		usleep ( WaitingPause * 1000 );
+		waiting -= WaitingPause;
 	}
-	auto result = getPng { image } ();
+	auto result = getPng { image, Level } ();
 	XDestroyImage( image );
 	return result;
 }
@@ -161,8 +166,7 @@ std::optional<std::wstring> Shooter::windowTitle ( Window Frame ) {
 	if ( !rows || !*strings ) {
 		return std::nullopt;
 	}
-	std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-	auto result = converter.from_bytes ( *strings );
+	auto result = Chars::StringToWide ( *strings );
 	XFreeStringList ( strings );
 	return result;
 }
@@ -208,7 +212,7 @@ std::optional<Window> Shooter::findWindow ( const std::wstring& Pattern ) {
 	return found ? std::optional ( window ) : std::nullopt;
 }
 
-Shooter::getPng::getPng ( XImage* Image ) : Image ( Image ) {}
+Shooter::getPng::getPng ( XImage* Image, int Level ) : Image ( Image ), Level ( Level ) {}
 
 Shooter::RawBuffer Shooter::getPng::operator() () {
 	init ();
@@ -254,6 +258,9 @@ void Shooter::getPng::init () {
 	png_set_IHDR ( PngStructure, PngInfo, Image->width, Image->height, 8,
 				   PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE,
 				   PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE );
+	if ( Level >= 0 ) {
+		png_set_compression_level ( PngStructure, Level );
+	}
 	png_write_info ( PngStructure, PngInfo );
 }
 
@@ -11,6 +11,8 @@
 #include <png.h>
 
 class Shooter {
+	// The benchmarks encode synthetic images through getPng
+	friend struct ShooterBenchmark;
 public:
 	struct RawBuffer {
 		char* Buffer;
@@ -25,14 +27,17 @@ public:
 		RawBuffer& operator= ( RawBuffer&& Parent ) noexcept;
 	};
 
-	Shooter ();
+	// Activation is how long Take waits for the window in milliseconds, Level the zlib level of the PNG,
+	// -1 for the libpng default
+	explicit Shooter ( long Activation = 500, int Level = -1 );
 	~Shooter ();
 	void Minimize ( const std::wstring& Title );
 	void Maximize ( const std::wstring& Title );
 	std::optional<RawBuffer> Take ( const std::wstring& Title );
 private:
-	const int WaitingActivation { 500 };
-	const int WaitingPause { 100 };
+	const long WaitingActivation;
+	const long WaitingPause { 100 };
+	const int Level;
 
 	static int errorHandler ( [[maybe_unused]] Display* Screen, XErrorEvent* Error );
 	static auto now ();
@@ -43,10 +48,11 @@ private:
 	class getPng {
 	public:
 		getPng () = delete;
-		explicit getPng ( XImage* Image );
+		explicit getPng ( XImage* Image, int Level = -1 );
 		RawBuffer operator() ();
 	private:
 		XImage* Image;
+		int Level;
 		png_structp PngStructure;
 		png_infop PngInfo;
 		unsigned char* DisplayRow;
@@ -0,0 +1,101 @@
+#include "stats.h"
+#include <algorithm>
+#include <cmath>
+
+Statistics::Statistics ( size_t Methods ) : Methods ( new Counters[ Methods ] ), Count ( Methods ) {
+	Reset ();
+}
+
+void Statistics::Record ( size_t Method, std::chrono::nanoseconds Elapsed, bool Succeeded, uint64_t BytesIn,
+						  uint64_t BytesOut ) {
+	if ( Method >= Count ) {
+		return;
+	}
+	auto& method = Methods[ Method ];
+	auto elapsed = static_cast<uint64_t> ( std::max<int64_t> ( Elapsed.count (), 0 ) );
+	method.Calls.fetch_add ( 1, std::memory_order_relaxed );
+	if ( !Succeeded ) {
+		method.Errors.fetch_add ( 1, std::memory_order_relaxed );
+	}
+	method.BytesIn.fetch_add ( BytesIn, std::memory_order_relaxed );
+	method.BytesOut.fetch_add ( BytesOut, std::memory_order_relaxed );
+	method.Total.fetch_add ( elapsed, std::memory_order_relaxed );
+	method.Histogram[ bucket ( elapsed ) ].fetch_add ( 1, std::memory_order_relaxed );
+	auto max = method.Max.load ( std::memory_order_relaxed );
+	while ( elapsed > max && !method.Max.compare_exchange_weak ( max, elapsed, std::memory_order_relaxed ) ) {}
+}
+
+Statistics::Summary Statistics::Summarize ( size_t Method ) const {
+	Summary result {};
+	if ( Method >= Count ) {
+		return result;
+	}
+	auto& method = Methods[ Method ];
+	result.Calls = method.Calls.load ( std::memory_order_relaxed );
+	result.Errors = method.Errors.load ( std::memory_order_relaxed );
+	result.BytesIn = method.BytesIn.load ( std::memory_order_relaxed );
+	result.BytesOut = method.BytesOut.load ( std::memory_order_relaxed );
+	result.Total = method.Total.load ( std::memory_order_relaxed );
+	result.Max = method.Max.load ( std::memory_order_relaxed );
+	if ( result.Calls ) {
+		result.Mean = result.Total / result.Calls;
+		result.P50 = percentile ( method, result.Calls, 0.50 );
+		result.P95 = percentile ( method, result.Calls, 0.95 );
+		result.P99 = percentile ( method, result.Calls, 0.99 );
+	}
+	return result;
+}
+
+void Statistics::Reset () {
+	for ( size_t i = 0; i < Count; ++i ) {
+		auto& method = Methods[ i ];
+		for ( auto counter : { &method.Calls, &method.Errors, &method.BytesIn, &method.BytesOut, &method.Total,
+							   &method.Max } ) {
+			counter->store ( 0, std::memory_order_relaxed );
+		}
+		for ( auto& bucket : method.Histogram ) {
+			bucket.store ( 0, std::memory_order_relaxed );
+		}
+	}
+}
+
+size_t Statistics::bucket ( uint64_t Value ) {
+	if ( Value < Steps ) {
+		return Value;
+	}
+	unsigned power { Shift };
+	while ( power < Powers + Shift - 1 && Value >> ( power + 1 ) ) {
+		++power;
+	}
+	auto step = std::min<uint64_t> ( ( Value >> ( power - Shift ) ) - Steps, Steps - 1 );
+	return ( power - Shift + 1 ) * Steps + step;
+}
+
+// The middle of the bucket, in nanoseconds
+uint64_t Statistics::value ( size_t Bucket ) {
+	if ( Bucket < Steps ) {
+		return Bucket;
+	}
+	auto shift = Bucket / Steps - 1;
+	auto step = Bucket % Steps;
+	return ( ( Steps + step ) << shift ) + ( ( 1ull << shift ) >> 1 );
+}
+
+// Counts are read one bucket at a time while calls go on, so the rank is capped by what was seen
+uint64_t Statistics::percentile ( const Counters& Method, uint64_t Calls, double Share ) {
+	auto rank = std::max<uint64_t> ( 1, static_cast<uint64_t> ( std::ceil ( Calls * Share ) ) );
+	uint64_t seen { 0 };
+	size_t last { 0 };
+	for ( size_t i = 0; i < Buckets; ++i ) {
+		auto count = Method.Histogram[ i ].load ( std::memory_order_relaxed );
+		if ( !count ) {
+			continue;
+		}
+		last = i;
+		seen += count;
+		if ( seen >= rank ) {
+			break;
+		}
+	}
+	return std::min ( value ( last ), Method.Max.load ( std::memory_order_relaxed ) );
+}
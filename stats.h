@@ -0,0 +1,56 @@
+#ifndef __stats_h__
+#define __stats_h__
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Per-method counters, updated without locks from whichever thread makes the call. Latencies go to
+// a log-linear histogram, HDR style: below Steps nanoseconds every value has its own bucket, above
+// that every power of two is split into Steps buckets, so percentiles are off by 1/Steps at most
+class Statistics {
+public:
+	// Times in nanoseconds
+	struct Summary {
+		uint64_t Calls;
+		uint64_t Errors;
+		uint64_t BytesIn;
+		uint64_t BytesOut;
+		uint64_t Total;
+		uint64_t Mean;
+		uint64_t P50;
+		uint64_t P95;
+		uint64_t P99;
+		uint64_t Max;
+	};
+
+	explicit Statistics ( size_t Methods );
+	void Record ( size_t Method, std::chrono::nanoseconds Elapsed, bool Succeeded, uint64_t BytesIn, uint64_t BytesOut );
+	[[nodiscard]] Summary Summarize ( size_t Method ) const;
+	void Reset ();
+private:
+	static constexpr unsigned Shift { 4 };
+	static constexpr unsigned Steps { 1 << Shift };
+	// Powers of two above Steps, up to 2^41 ns which is over half an hour
+	static constexpr unsigned Powers { 41 - Shift };
+	static constexpr size_t Buckets { ( Powers + 1 ) * Steps };
+
+	struct Counters {
+		std::atomic<uint64_t> Calls;
+		std::atomic<uint64_t> Errors;
+		std::atomic<uint64_t> BytesIn;
+		std::atomic<uint64_t> BytesOut;
+		std::atomic<uint64_t> Total;
+		std::atomic<uint64_t> Max;
+		std::atomic<uint64_t> Histogram[ Buckets ];
+	};
+
+	std::unique_ptr<Counters[]> Methods;
+	size_t Count;
+
+	static size_t bucket ( uint64_t Value );
+	static uint64_t value ( size_t Bucket );
+	static uint64_t percentile ( const Counters& Method, uint64_t Calls, double Share );
+};
+#endif
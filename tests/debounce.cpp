@@ -0,0 +1,128 @@
+#include "debounce.h"
+#include <doctest/doctest.h>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+	using Change = Debouncer::Change;
+
+	struct Sent {
+		Change Net;
+		Debouncer::Text Path;
+	};
+
+	Debouncer::Text text ( const char* Source ) {
+		return { Source, Source + std::char_traits<char>::length ( Source ) };
+	}
+
+	// Collects what the debouncer sends, the lock of the debouncer is held while it is called
+	struct Collector {
+		std::vector<Sent> Items;
+		Debouncer Changes { [ this ] ( Change Net, bool, const Debouncer::Text& Path ) {
+			Items.push_back ( { Net, Path } );
+		} };
+
+		void add ( const char* Path, Change Event, long Window = Debouncer::MaxWindow ) {
+			Changes.Add ( text ( Path ), Event, false, Window );
+		}
+
+		void flush ( const char* Path ) {
+			Changes.Flush ( text ( Path ) );
+		}
+	};
+}
+
+TEST_CASE ( "Debouncer::merge" ) {
+	Collector collector;
+	SUBCASE ( "added then changed is added" ) {
+		collector.add ( "a", Change::Added );
+		collector.add ( "a", Change::Changed );
+		collector.flush ( "a" );
+		REQUIRE ( collector.Items.size () == 1 );
+		CHECK ( collector.Items[ 0 ].Net == Change::Added );
+	}
+	SUBCASE ( "added then removed is not sent" ) {
+		collector.add ( "a", Change::Added );
+		collector.add ( "a", Change::Removed );
+		collector.flush ( "a" );
+		collector.Changes.Stop ();
+		CHECK ( collector.Items.empty () );
+	}
+	SUBCASE ( "moved in then removed or moved out is not sent" ) {
+		collector.add ( "a", Change::RenamedNew );
+		collector.add ( "a", Change::Removed );
+		collector.add ( "b", Change::RenamedNew );
+		collector.add ( "b", Change::RenamedOld );
+		collector.flush ( "a" );
+		collector.flush ( "b" );
+		CHECK ( collector.Items.empty () );
+	}
+	SUBCASE ( "removed then added is changed" ) {
+		collector.add ( "a", Change::Removed );
+		collector.add ( "a", Change::Added );
+		collector.flush ( "a" );
+		REQUIRE ( collector.Items.size () == 1 );
+		CHECK ( collector.Items[ 0 ].Net == Change::Changed );
+	}
+	SUBCASE ( "paths are kept apart" ) {
+		collector.add ( "a", Change::Added );
+		collector.add ( "b", Change::Removed );
+		collector.flush ( "b" );
+		REQUIRE ( collector.Items.size () == 1 );
+		CHECK ( collector.Items[ 0 ].Path == text ( "b" ) );
+	}
+}
+
+TEST_CASE ( "Debouncer::FlushAll" ) {
+	Collector collector;
+	collector.add ( "a", Change::Added, 5000 );
+	collector.add ( "b", Change::Removed, 2000 );
+	collector.Changes.FlushAll ();
+	REQUIRE ( collector.Items.size () == 2 );
+	CHECK ( collector.Items[ 0 ].Path == text ( "b" ) );
+	CHECK ( collector.Items[ 1 ].Path == text ( "a" ) );
+}
+
+TEST_CASE ( "Debouncer expiry" ) {
+	// Sent from the thread of the debouncer
+	std::mutex lock;
+	std::vector<Change> sent;
+	Debouncer changes ( [ & ] ( Change Net, bool, const Debouncer::Text& ) {
+		std::lock_guard<std::mutex> guard ( lock );
+		sent.push_back ( Net );
+	} );
+	auto count = [ & ] {
+		std::lock_guard<std::mutex> guard ( lock );
+		return sent.size ();
+	};
+	SUBCASE ( "a quiet path is sent after the window" ) {
+		changes.Add ( text ( "a" ), Change::Changed, false, 20 );
+		auto deadline = std::chrono::steady_clock::now () + std::chrono::seconds ( 5 );
+		while ( !count () && std::chrono::steady_clock::now () < deadline ) {
+			std::this_thread::sleep_for ( std::chrono::milliseconds ( 10 ) );
+		}
+		REQUIRE ( count () == 1 );
+		changes.Stop ();
+		CHECK ( sent[ 0 ] == Change::Changed );
+	}
+	SUBCASE ( "a long window is not sent early, stop sends it" ) {
+		changes.Add ( text ( "a" ), Change::Removed, false, Debouncer::MaxWindow );
+		std::this_thread::sleep_for ( std::chrono::milliseconds ( 50 ) );
+		CHECK ( count () == 0 );
+		changes.Stop ();
+		REQUIRE ( sent.size () == 1 );
+		CHECK ( sent[ 0 ] == Change::Removed );
+	}
+	SUBCASE ( "nothing is taken after stop until start" ) {
+		changes.Stop ();
+		changes.Add ( text ( "a" ), Change::Added, false, 20 );
+		changes.Flush ( text ( "a" ) );
+		CHECK ( count () == 0 );
+		changes.Start ();
+		changes.Add ( text ( "a" ), Change::Added, false, 20 );
+		changes.Flush ( text ( "a" ) );
+		CHECK ( count () == 1 );
+	}
+}
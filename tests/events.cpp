@@ -0,0 +1,96 @@
+#include "events.h"
+#include <doctest/doctest.h>
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+	Dispatcher::Text text ( const char* Source ) {
+		return { Source, Source + std::char_traits<char>::length ( Source ) };
+	}
+
+	// Holds the worker in the first delivery, so everything posted meanwhile waits together and is
+	// coalesced against the same queue whatever the timing
+	struct Recorder {
+		std::mutex Lock;
+		std::vector<std::pair<Dispatcher::Text, Dispatcher::Text>> Items;
+		std::promise<void> Entered;
+		std::promise<void> Released;
+		Dispatcher Events { [ this ] ( const WCHAR_T* Message, const WCHAR_T* Data ) {
+			if ( Dispatcher::Text ( Message ) == text ( "hold" ) ) {
+				Entered.set_value ();
+				Released.get_future ().wait ();
+				return;
+			}
+			std::lock_guard<std::mutex> guard ( Lock );
+			Items.emplace_back ( Message, Data );
+		} };
+
+		explicit Recorder ( bool Coalescing ) {
+			Events.Tune ().Coalescing = Coalescing;
+			Events.Post ( text ( "hold" ), text ( "" ) );
+			Entered.get_future ().wait ();
+		}
+
+		void post ( const char* Message, const char* Data ) {
+			Events.Post ( text ( Message ), text ( Data ) );
+		}
+
+		std::vector<std::string> finish () {
+			Released.set_value ();
+			Events.Stop ();
+			std::vector<std::string> result;
+			for ( auto& [ message, data ] : Items ) {
+				result.emplace_back ( std::string ( message.begin (), message.end () ) + " "
+									  + std::string ( data.begin (), data.end () ) );
+			}
+			return result;
+		}
+	};
+}
+
+TEST_CASE ( "Dispatcher coalescing" ) {
+	SUBCASE ( "a repeat of the latest event with the same data is dropped" ) {
+		Recorder recorder ( true );
+		recorder.post ( "create", "x" );
+		recorder.post ( "create", "x" );
+		recorder.post ( "create", "y" );
+		recorder.post ( "create", "x" );
+		std::vector<std::string> expected { "create x", "create y" };
+		CHECK ( recorder.finish () == expected );
+		CHECK ( recorder.Events.Measure ().Coalesced == 2 );
+		CHECK ( recorder.Events.Measure ().Delivered == 3 );
+	}
+	SUBCASE ( "a repeat does not jump over a different event about the same data" ) {
+		Recorder recorder ( true );
+		recorder.post ( "create", "x" );
+		recorder.post ( "delete", "x" );
+		recorder.post ( "create", "x" );
+		std::vector<std::string> expected { "create x", "delete x", "create x" };
+		CHECK ( recorder.finish () == expected );
+		CHECK ( recorder.Events.Measure ().Coalesced == 0 );
+	}
+	SUBCASE ( "every event is delivered when coalescing is off" ) {
+		Recorder recorder ( false );
+		recorder.post ( "create", "x" );
+		recorder.post ( "create", "x" );
+		std::vector<std::string> expected { "create x", "create x" };
+		CHECK ( recorder.finish () == expected );
+	}
+}
+
+TEST_CASE ( "Dispatcher batches" ) {
+	Recorder recorder ( false );
+	// Taken by the worker once the held delivery returns, Stop cuts the wait short
+	recorder.Events.Tune ().Latency = 60000;
+	recorder.post ( "create", "x" );
+	recorder.post ( "create", "y" );
+	recorder.post ( "delete", "x" );
+	auto items = recorder.finish ();
+	REQUIRE ( items.size () == 1 );
+	CHECK ( items[ 0 ].rfind ( "###B### ", 0 ) == 0 );
+	auto metrics = recorder.Events.Measure ();
+	CHECK ( metrics.Delivered == 4 );
+	CHECK ( metrics.Batches == 1 );
+}
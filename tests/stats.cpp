@@ -0,0 +1,42 @@
+#include "stats.h"
+#include <doctest/doctest.h>
+
+namespace {
+	// The median of many calls of Value and one far longer call, so it is the middle of the bucket of
+	// Value and not capped by the maximum
+	uint64_t median ( uint64_t Value ) {
+		Statistics statistics ( 1 );
+		for ( auto i = 0; i < 99; ++i ) {
+			statistics.Record ( 0, std::chrono::nanoseconds ( Value ), true, 0, 0 );
+		}
+		statistics.Record ( 0, std::chrono::hours ( 1 ), true, 0, 0 );
+		return statistics.Summarize ( 0 ).P50;
+	}
+}
+
+TEST_CASE ( "Statistics::bucket" ) {
+	SUBCASE ( "small values have buckets of their own" ) {
+		for ( uint64_t value = 0; value < 16; ++value ) {
+			CHECK ( median ( value ) == value );
+		}
+	}
+	SUBCASE ( "larger values are off by a sixteenth at most" ) {
+		for ( uint64_t value = 16; value < ( 1ull << 40 ); value = value * 3 / 2 + 1 ) {
+			auto middle = median ( value );
+			CHECK ( middle + value / 16 >= value );
+			CHECK ( middle <= value + value / 16 );
+		}
+	}
+	SUBCASE ( "neighbouring buckets stay apart" ) {
+		CHECK ( median ( 16 ) < median ( 17 ) );
+		CHECK ( median ( 1000 ) < median ( 1100 ) );
+	}
+	SUBCASE ( "values past the range fall into the last bucket" ) {
+		Statistics statistics ( 1 );
+		statistics.Record ( 0, std::chrono::nanoseconds ( 1ull << 60 ), true, 0, 0 );
+		statistics.Record ( 0, std::chrono::nanoseconds ( 1ull << 62 ), true, 0, 0 );
+		auto summary = statistics.Summarize ( 0 );
+		CHECK ( summary.P50 <= summary.Max );
+		CHECK ( summary.P50 >= ( 1ull << 40 ) );
+	}
+}
@@ -0,0 +1,187 @@
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> Tracer::Enabled { false };
+
+namespace {
+	// Spans a thread keeps, the older ones are overwritten
+	constexpr uint64_t Capacity { 1 << 13 };
+
+	// Fields are atomic for Write reading a ring its thread is appending to, relaxed stores cost nothing
+	struct Event {
+		std::atomic<const wchar_t*> Name;
+		std::atomic<size_t> Length;
+		std::atomic<const char*> Category;
+		std::atomic<uint64_t> Start;
+		std::atomic<uint64_t> End;
+	};
+
+	struct Ring {
+		Event Events[ Capacity ];
+		// Spans ever appended, and the first one of the current session
+		std::atomic<uint64_t> Head { 0 };
+		std::atomic<uint64_t> Base { 0 };
+		std::atomic<const char*> Label { nullptr };
+		std::atomic<bool> Owned { true };
+		int64_t Id;
+	};
+
+	struct Copy {
+		std::wstring_view Name;
+		const char* Category;
+		uint64_t Start;
+		uint64_t End;
+		int64_t Thread;
+	};
+
+	// Rings outlive their threads, so spans of a finished Watcher are still written out. A ring
+	// whose thread has gone is taken by a new thread once a new session leaves it empty
+	std::mutex lock;
+	std::vector<std::unique_ptr<Ring>> rings;
+	std::atomic<uint64_t> origin { 0 };
+
+	struct Holder {
+		Ring* Taken { nullptr };
+		const char* Label { nullptr };
+
+		~Holder () {
+			if ( Taken ) {
+				Taken->Owned.store ( false, std::memory_order_release );
+			}
+		}
+	};
+
+	thread_local Holder holder;
+
+	Ring& local () {
+		if ( holder.Taken ) {
+			return *holder.Taken;
+		}
+		std::lock_guard<std::mutex> guard ( lock );
+		for ( auto& ring : rings ) {
+			if ( !ring->Owned.load ( std::memory_order_acquire )
+				 && ring->Head.load ( std::memory_order_relaxed ) == ring->Base.load ( std::memory_order_relaxed ) ) {
+				ring->Owned.store ( true, std::memory_order_relaxed );
+				holder.Taken = ring.get ();
+				break;
+			}
+		}
+		if ( !holder.Taken ) {
+			rings.push_back ( std::make_unique<Ring> () );
+			rings.back ()->Id = static_cast<int64_t> ( rings.size () );
+			holder.Taken = rings.back ().get ();
+		}
+		holder.Taken->Label.store ( holder.Label, std::memory_order_relaxed );
+		return *holder.Taken;
+	}
+
+	// Trace times are microseconds, three decimals keep nanoseconds without the noise of a double
+	void microseconds ( JSON::Writer<WCHAR_T>& Json, uint64_t Nanoseconds ) {
+		char digits[32];
+		auto size = std::snprintf ( digits, sizeof digits, "%llu.%03llu",
+									static_cast<unsigned long long> ( Nanoseconds / 1000 ),
+									static_cast<unsigned long long> ( Nanoseconds % 1000 ) );
+		WCHAR_T units[32];
+		std::copy ( digits, digits + size, units );
+		Json.Raw ( { units, static_cast<size_t> ( size ) } );
+	}
+}
+
+uint64_t Tracer::now () {
+	return static_cast<uint64_t> ( std::chrono::duration_cast<std::chrono::nanoseconds> (
+			std::chrono::steady_clock::now ().time_since_epoch () ).count () );
+}
+
+// One writer per ring, so claiming a slot is a plain increment. The fence keeps the slot stores
+// from showing up before the head that tells Write the slot is being reused
+void Tracer::record ( std::wstring_view Name, const char* Category, uint64_t Start, uint64_t End ) {
+	auto& ring = local ();
+	auto index = ring.Head.load ( std::memory_order_relaxed );
+	auto& event = ring.Events[ index & ( Capacity - 1 ) ];
+	std::atomic_thread_fence ( std::memory_order_release );
+	event.Name.store ( Name.data (), std::memory_order_relaxed );
+	event.Length.store ( Name.size (), std::memory_order_relaxed );
+	event.Category.store ( Category, std::memory_order_relaxed );
+	event.Start.store ( Start, std::memory_order_relaxed );
+	event.End.store ( End, std::memory_order_relaxed );
+	ring.Head.store ( index + 1, std::memory_order_release );
+}
+
+void Tracer::Start () {
+	std::lock_guard<std::mutex> guard ( lock );
+	for ( auto& ring : rings ) {
+		ring->Base.store ( ring->Head.load ( std::memory_order_relaxed ), std::memory_order_relaxed );
+	}
+	origin.store ( now (), std::memory_order_relaxed );
+	Enabled.store ( true, std::memory_order_release );
+}
+
+void Tracer::Stop () {
+	Enabled.store ( false, std::memory_order_release );
+}
+
+void Tracer::Label ( const char* Name ) {
+	holder.Label = Name;
+	if ( holder.Taken ) {
+		holder.Taken->Label.store ( Name, std::memory_order_relaxed );
+	}
+}
+
+// Spans are copied first and kept only if their slots were not reused meanwhile
+void Tracer::Write ( JSON::Writer<WCHAR_T>& Json ) {
+	std::vector<Copy> spans;
+	std::vector<std::pair<int64_t, const char*>> labels;
+	{
+		std::lock_guard<std::mutex> guard ( lock );
+		for ( auto& ring : rings ) {
+			auto head = ring->Head.load ( std::memory_order_acquire );
+			auto first = std::max ( ring->Base.load ( std::memory_order_relaxed ), head > Capacity ? head - Capacity : 0 );
+			auto copied = spans.size ();
+			for ( auto i = first; i < head; ++i ) {
+				auto& event = ring->Events[ i & ( Capacity - 1 ) ];
+				spans.push_back ( { { event.Name.load ( std::memory_order_relaxed ),
+									  event.Length.load ( std::memory_order_relaxed ) },
+									event.Category.load ( std::memory_order_relaxed ),
+									event.Start.load ( std::memory_order_relaxed ),
+									event.End.load ( std::memory_order_relaxed ), ring->Id } );
+			}
+			std::atomic_thread_fence ( std::memory_order_acquire );
+			auto last = ring->Head.load ( std::memory_order_relaxed );
+			if ( last >= first + Capacity ) {
+				auto reused = std::min<uint64_t> ( last - Capacity + 1 - first, spans.size () - copied );
+				spans.erase ( spans.begin () + static_cast<ptrdiff_t> ( copied ),
+							  spans.begin () + static_cast<ptrdiff_t> ( copied + reused ) );
+			}
+			if ( head > first || ring->Owned.load ( std::memory_order_relaxed ) ) {
+				if ( auto label = ring->Label.load ( std::memory_order_relaxed ) ) {
+					labels.emplace_back ( ring->Id, label );
+				}
+			}
+		}
+	}
+	std::stable_sort ( spans.begin (), spans.end (), [] ( const Copy& Left, const Copy& Right ) {
+		return Left.Start < Right.Start;
+	} );
+	auto zero = origin.load ( std::memory_order_relaxed );
+	Json.BeginObject ().Key ( L"traceEvents" ).BeginArray ();
+	for ( auto [ thread, label ] : labels ) {
+		Json.BeginObject ().Key ( L"name" ).String ( L"thread_name" ).Key ( L"ph" ).String ( L"M" );
+		Json.Key ( L"pid" ).Number ( int64_t { 1 } ).Key ( L"tid" ).Number ( thread );
+		Json.Key ( L"args" ).BeginObject ().Key ( L"name" ).String ( std::string_view ( label ) ).EndObject ();
+		Json.EndObject ();
+	}
+	for ( auto& span : spans ) {
+		Json.BeginObject ().Key ( L"name" ).String ( span.Name ).Key ( L"cat" ).String ( std::string_view ( span.Category ) );
+		Json.Key ( L"ph" ).String ( L"X" ).Key ( L"ts" );
+		microseconds ( Json, span.Start > zero ? span.Start - zero : 0 );
+		Json.Key ( L"dur" );
+		microseconds ( Json, span.End > span.Start ? span.End - span.Start : 0 );
+		Json.Key ( L"pid" ).Number ( int64_t { 1 } ).Key ( L"tid" ).Number ( span.Thread ).EndObject ();
+	}
+	Json.EndArray ().Key ( L"displayTimeUnit" ).String ( L"ns" ).EndObject ();
+}
@@ -0,0 +1,53 @@
+#ifndef __trace_h__
+#define __trace_h__
+#include <atomic>
+#include <cstdint>
+#include <string_view>
+#include "1c/types.h"
+#include "json.h"
+
+// Timeline of component activity in the Chrome trace event format, which chrome://tracing and Perfetto
+// open. Every thread appends finished spans to its own ring without locks, a full ring overwrites its
+// oldest spans. While tracing is off a span costs one relaxed load, so it stays in release builds.
+// Names and categories are kept by pointer and must live as long as the module, literals do
+class Tracer {
+public:
+	class Span {
+	public:
+		Span ( std::wstring_view Name, const char* Category ) : Name ( Name ), Category ( Category ),
+																 Start ( Active () ? now () : Off ) {}
+
+		~Span () {
+			if ( Start != Off ) {
+				record ( Name, Category, Start, now () );
+			}
+		}
+
+		Span ( const Span& ) = delete;
+		Span& operator= ( const Span& ) = delete;
+	private:
+		static constexpr uint64_t Off { ~0ull };
+
+		std::wstring_view Name;
+		const char* Category;
+		uint64_t Start;
+	};
+
+	static bool Active () {
+		return Enabled.load ( std::memory_order_relaxed );
+	}
+
+	// Start drops spans of the previous session, Stop keeps them until Write
+	static void Start ();
+	static void Stop ();
+	// Names the calling thread on the timeline
+	static void Label ( const char* Name );
+	// A complete trace document, spans of all threads sorted by start
+	static void Write ( JSON::Writer<WCHAR_T>& Json );
+private:
+	static std::atomic<bool> Enabled;
+
+	static uint64_t now ();
+	static void record ( std::wstring_view Name, const char* Category, uint64_t Start, uint64_t End );
+};
+#endif
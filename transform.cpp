@@ -33,4 +33,31 @@ std::string trim ( std::string&& string ) {
 	trim ( string );
 	return std::move ( string );
 }
+
+std::string toBase64 ( std::string_view data ) {
+	static constexpr char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	std::string result;
+	result.reserve ( ( data.size () + 2 ) / 3 * 4 );
+	size_t i = 0;
+	for ( ; i + 3 <= data.size (); i += 3 ) {
+		uint32_t triple = static_cast<unsigned char> ( data [ i ] ) << 16
+										| static_cast<unsigned char> ( data [ i + 1 ] ) << 8
+										| static_cast<unsigned char> ( data [ i + 2 ] );
+		result += alphabet [ triple >> 18 ];
+		result += alphabet [ triple >> 12 & 63 ];
+		result += alphabet [ triple >> 6 & 63 ];
+		result += alphabet [ triple & 63 ];
+	}
+	if ( auto rest = data.size () - i ) {
+		uint32_t triple = static_cast<unsigned char> ( data [ i ] ) << 16;
+		if ( rest == 2 ) {
+			triple |= static_cast<unsigned char> ( data [ i + 1 ] ) << 8;
+		}
+		result += alphabet [ triple >> 18 ];
+		result += alphabet [ triple >> 12 & 63 ];
+		result += rest == 2 ? alphabet [ triple >> 6 & 63 ] : '=';
+		result += '=';
+	}
+	return result;
+}
 }
@@ -1,9 +1,11 @@
 #pragma once
 #include <cstdint>
 #include <string>
+#include <string_view>
 
 namespace strings {
 uint64_t toHash ( const std::string& string );
 void trim ( std::string& string );
 [[nodiscard]] std::string trim ( std::string&& string );
+[[nodiscard]] std::string toBase64 ( std::string_view data );
 }
@@ -0,0 +1,381 @@
+#include "unicode.h"
+#include "1c/types.h"
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define UNICODE_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace unicode {
+namespace {
+constexpr char32_t invalid { 0xFFFFFFFF };
+
+#ifdef UNICODE_SSE2
+inline unsigned first ( int mask ) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward ( &index, mask );
+	return index;
+#else
+	return __builtin_ctz ( mask );
+#endif
+}
+
+// Widens 16 ASCII bytes into 16 units
+template <typename Unit>
+void widen ( __m128i block, Unit* out ) {
+	auto zero = _mm_setzero_si128 ();
+	auto low = _mm_unpacklo_epi8 ( block, zero );
+	auto high = _mm_unpackhi_epi8 ( block, zero );
+	auto target = reinterpret_cast<__m128i*> ( out );
+	if constexpr ( sizeof ( Unit ) == 2 ) {
+		_mm_storeu_si128 ( target, low );
+		_mm_storeu_si128 ( target + 1, high );
+	} else {
+		_mm_storeu_si128 ( target, _mm_unpacklo_epi16 ( low, zero ) );
+		_mm_storeu_si128 ( target + 1, _mm_unpackhi_epi16 ( low, zero ) );
+		_mm_storeu_si128 ( target + 2, _mm_unpacklo_epi16 ( high, zero ) );
+		_mm_storeu_si128 ( target + 3, _mm_unpackhi_epi16 ( high, zero ) );
+	}
+}
+
+// Narrows 16 units into bytes when all of them are ASCII
+template <typename Unit>
+bool narrow ( const Unit* data, unsigned char* out ) {
+	auto source = reinterpret_cast<const __m128i*> ( data );
+	auto zero = _mm_setzero_si128 ();
+	__m128i bytes;
+	if constexpr ( sizeof ( Unit ) == 2 ) {
+		auto a = _mm_loadu_si128 ( source );
+		auto b = _mm_loadu_si128 ( source + 1 );
+		auto high = _mm_and_si128 ( _mm_or_si128 ( a, b ), _mm_set1_epi16 ( static_cast<short> ( 0xFF80 ) ) );
+		if ( _mm_movemask_epi8 ( _mm_cmpeq_epi16 ( high, zero ) ) != 0xFFFF ) {
+			return false;
+		}
+		bytes = _mm_packus_epi16 ( a, b );
+	} else {
+		auto a = _mm_loadu_si128 ( source );
+		auto b = _mm_loadu_si128 ( source + 1 );
+		auto c = _mm_loadu_si128 ( source + 2 );
+		auto d = _mm_loadu_si128 ( source + 3 );
+		auto all = _mm_or_si128 ( _mm_or_si128 ( a, b ), _mm_or_si128 ( c, d ) );
+		auto high = _mm_and_si128 ( all, _mm_set1_epi32 ( static_cast<int> ( 0xFFFFFF80 ) ) );
+		if ( _mm_movemask_epi8 ( _mm_cmpeq_epi32 ( high, zero ) ) != 0xFFFF ) {
+			return false;
+		}
+		bytes = _mm_packus_epi16 ( _mm_packs_epi32 ( a, b ), _mm_packs_epi32 ( c, d ) );
+	}
+	_mm_storeu_si128 ( reinterpret_cast<__m128i*> ( out ), bytes );
+	return true;
+}
+#endif
+
+// Decodes the sequence at a non-ASCII lead byte. On error only the maximal valid prefix is consumed
+inline char32_t next ( const unsigned char* data, size_t size, size_t& i ) {
+	unsigned lead = data [ i++ ];
+	if ( lead >= 0xC2 && lead <= 0xDF ) {
+		if ( i < size && ( data [ i ] & 0xC0 ) == 0x80 ) {
+			return ( lead & 0x1F ) << 6 | ( data [ i++ ] & 0x3F );
+		}
+		return invalid;
+	}
+	unsigned need;
+	unsigned low { 0x80 };
+	unsigned high { 0xBF };
+	char32_t code;
+	if ( lead >= 0xE0 && lead <= 0xEF ) {
+		need = 2;
+		code = lead & 0x0F;
+		low = lead == 0xE0 ? 0xA0 : low;
+		high = lead == 0xED ? 0x9F : high;
+	} else if ( lead >= 0xF0 && lead <= 0xF4 ) {
+		need = 3;
+		code = lead & 0x07;
+		low = lead == 0xF0 ? 0x90 : low;
+		high = lead == 0xF4 ? 0x8F : high;
+	} else {
+		return invalid;
+	}
+	for ( ; need; --need ) {
+		if ( i == size || data [ i ] < low || data [ i ] > high ) {
+			return invalid;
+		}
+		code = code << 6 | ( data [ i++ ] & 0x3F );
+		low = 0x80;
+		high = 0xBF;
+	}
+	return code;
+}
+
+template <typename Unit, bool Pairs>
+void decode ( std::string_view source, std::basic_string<Unit>& result ) {
+	auto data = reinterpret_cast<const unsigned char*> ( source.data () );
+	auto size = source.size ();
+	auto start = result.size ();
+	result.resize ( start + size );
+	auto out = result.data () + start;
+	size_t i { 0 };
+	while ( i < size ) {
+#ifdef UNICODE_SSE2
+		if ( i + 16 <= size ) {
+			auto block = _mm_loadu_si128 ( reinterpret_cast<const __m128i*> ( data + i ) );
+			auto mask = _mm_movemask_epi8 ( block );
+			if ( !mask ) {
+				widen ( block, out );
+				out += 16;
+				i += 16;
+				continue;
+			}
+			for ( auto end = i + first ( mask ); i < end; ) {
+				*out++ = static_cast<Unit> ( data [ i++ ] );
+			}
+		}
+#endif
+		if ( data [ i ] < 0x80 ) {
+			*out++ = static_cast<Unit> ( data [ i++ ] );
+			continue;
+		}
+		while ( i < size && data [ i ] >= 0x80 ) {
+			auto code = next ( data, size, i );
+			if ( code == invalid ) {
+				code = replacement;
+			}
+			if ( Pairs && code > 0xFFFF ) {
+				code -= 0x10000;
+				*out++ = static_cast<Unit> ( 0xD800 + ( code >> 10 ) );
+				code = 0xDC00 + ( code & 0x3FF );
+			}
+			*out++ = static_cast<Unit> ( code );
+		}
+	}
+	result.resize ( out - result.data () );
+}
+
+inline unsigned char* put ( char32_t code, unsigned char* out ) {
+	if ( code < 0x80 ) {
+		*out++ = static_cast<unsigned char> ( code );
+	} else if ( code < 0x800 ) {
+		*out++ = static_cast<unsigned char> ( 0xC0 | code >> 6 );
+		*out++ = static_cast<unsigned char> ( 0x80 | ( code & 0x3F ) );
+	} else if ( code < 0x10000 ) {
+		*out++ = static_cast<unsigned char> ( 0xE0 | code >> 12 );
+		*out++ = static_cast<unsigned char> ( 0x80 | ( code >> 6 & 0x3F ) );
+		*out++ = static_cast<unsigned char> ( 0x80 | ( code & 0x3F ) );
+	} else {
+		*out++ = static_cast<unsigned char> ( 0xF0 | code >> 18 );
+		*out++ = static_cast<unsigned char> ( 0x80 | ( code >> 12 & 0x3F ) );
+		*out++ = static_cast<unsigned char> ( 0x80 | ( code >> 6 & 0x3F ) );
+		*out++ = static_cast<unsigned char> ( 0x80 | ( code & 0x3F ) );
+	}
+	return out;
+}
+
+// Code point at the unit, surrogate pairs are joined when Pairs is set, everything else invalid is replaced
+template <typename Unit, bool Pairs>
+char32_t point ( const Unit* data, size_t size, size_t& i ) {
+	uint32_t code = static_cast<std::make_unsigned_t<Unit>> ( data [ i++ ] );
+	if ( code >= 0xD800 && code <= 0xDFFF ) {
+		if ( Pairs && code <= 0xDBFF && i < size ) {
+			uint32_t low = static_cast<std::make_unsigned_t<Unit>> ( data [ i ] );
+			if ( low >= 0xDC00 && low <= 0xDFFF ) {
+				++i;
+				return 0x10000 + ( ( code - 0xD800 ) << 10 ) + ( low - 0xDC00 );
+			}
+		}
+		return replacement;
+	}
+	return code > 0x10FFFF ? replacement : code;
+}
+
+template <typename Unit, bool Pairs>
+void encode ( std::basic_string_view<Unit> source, std::string& result ) {
+	auto data = source.data ();
+	auto size = source.size ();
+	auto start = result.size ();
+	result.resize ( start + size * ( sizeof ( Unit ) > 2 ? 4 : 3 ) );
+	auto out = reinterpret_cast<unsigned char*> ( result.data () + start );
+	size_t i { 0 };
+	while ( i < size ) {
+#ifdef UNICODE_SSE2
+		if ( i + 16 <= size && narrow ( data + i, out ) ) {
+			out += 16;
+			i += 16;
+			continue;
+		}
+#endif
+		for ( auto end = std::min ( size, i + 16 ); i < end; ) {
+			if ( static_cast<std::make_unsigned_t<Unit>> ( data [ i ] ) < 0x80 ) {
+				*out++ = static_cast<unsigned char> ( data [ i++ ] );
+			} else {
+				out = put ( point<Unit, Pairs> ( data, size, i ), out );
+			}
+		}
+	}
+	result.resize ( reinterpret_cast<char*> ( out ) - result.data () );
+}
+}
+
+template <typename Unit>
+void utf8To16 ( std::string_view source, std::basic_string<Unit>& result ) {
+	decode<Unit, true> ( source, result );
+}
+
+template <typename Unit>
+void utf8To32 ( std::string_view source, std::basic_string<Unit>& result ) {
+	static_assert ( sizeof ( Unit ) == 4 );
+	decode<Unit, false> ( source, result );
+}
+
+template <typename Unit>
+void utf16To8 ( std::basic_string_view<Unit> source, std::string& result ) {
+	encode<Unit, true> ( source, result );
+}
+
+template <typename Unit>
+void utf32To8 ( std::basic_string_view<Unit> source, std::string& result ) {
+	encode<Unit, false> ( source, result );
+}
+
+template <typename From, typename To>
+void utf16To32 ( std::basic_string_view<From> source, std::basic_string<To>& result ) {
+	static_assert ( sizeof ( To ) == 4 );
+	auto data = source.data ();
+	auto size = source.size ();
+	auto start = result.size ();
+	result.resize ( start + size );
+	auto out = result.data () + start;
+	size_t i { 0 };
+	while ( i < size ) {
+#ifdef UNICODE_SSE2
+		if constexpr ( sizeof ( From ) == 2 ) {
+			if ( i + 8 <= size ) {
+				auto block = _mm_loadu_si128 ( reinterpret_cast<const __m128i*> ( data + i ) );
+				auto surrogates = _mm_cmpeq_epi16 ( _mm_and_si128 ( block, _mm_set1_epi16 ( static_cast<short> ( 0xF800 ) ) ),
+													_mm_set1_epi16 ( static_cast<short> ( 0xD800 ) ) );
+				if ( !_mm_movemask_epi8 ( surrogates ) ) {
+					auto zero = _mm_setzero_si128 ();
+					_mm_storeu_si128 ( reinterpret_cast<__m128i*> ( out ), _mm_unpacklo_epi16 ( block, zero ) );
+					_mm_storeu_si128 ( reinterpret_cast<__m128i*> ( out ) + 1, _mm_unpackhi_epi16 ( block, zero ) );
+					out += 8;
+					i += 8;
+					continue;
+				}
+			}
+		}
+#endif
+		for ( auto end = std::min ( size, i + 8 ); i < end; ) {
+			*out++ = static_cast<To> ( point<From, true> ( data, size, i ) );
+		}
+	}
+	result.resize ( out - result.data () );
+}
+
+template <typename From, typename To>
+void utf32To16 ( std::basic_string_view<From> source, std::basic_string<To>& result ) {
+	auto data = source.data ();
+	auto size = source.size ();
+	auto start = result.size ();
+	result.resize ( start + size * 2 );
+	auto out = result.data () + start;
+	for ( size_t i = 0; i < size; ) {
+		auto code = point<From, false> ( data, size, i );
+		if ( code > 0xFFFF ) {
+			code -= 0x10000;
+			*out++ = static_cast<To> ( 0xD800 + ( code >> 10 ) );
+			code = 0xDC00 + ( code & 0x3FF );
+		}
+		*out++ = static_cast<To> ( code );
+	}
+	result.resize ( out - result.data () );
+}
+
+bool valid ( std::string_view source ) {
+	auto data = reinterpret_cast<const unsigned char*> ( source.data () );
+	auto size = source.size ();
+	size_t i { 0 };
+	while ( i < size ) {
+#ifdef UNICODE_SSE2
+		if ( i + 16 <= size ) {
+			auto mask = _mm_movemask_epi8 ( _mm_loadu_si128 ( reinterpret_cast<const __m128i*> ( data + i ) ) );
+			if ( !mask ) {
+				i += 16;
+				continue;
+			}
+			i += first ( mask );
+		}
+#endif
+		if ( data [ i ] < 0x80 ) {
+			++i;
+			continue;
+		}
+		while ( i < size && data [ i ] >= 0x80 ) {
+			if ( next ( data, size, i ) == invalid ) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Valid input is copied in one piece, only invalid sequences are cut out and replaced
+std::string fix ( std::string_view source ) {
+	std::string result;
+	result.reserve ( source.size () );
+	auto data = reinterpret_cast<const unsigned char*> ( source.data () );
+	auto size = source.size ();
+	size_t copied { 0 };
+	size_t i { 0 };
+	while ( i < size ) {
+#ifdef UNICODE_SSE2
+		if ( i + 16 <= size ) {
+			auto mask = _mm_movemask_epi8 ( _mm_loadu_si128 ( reinterpret_cast<const __m128i*> ( data + i ) ) );
+			if ( !mask ) {
+				i += 16;
+				continue;
+			}
+			i += first ( mask );
+		}
+#endif
+		if ( data [ i ] < 0x80 ) {
+			++i;
+			continue;
+		}
+		while ( i < size && data [ i ] >= 0x80 ) {
+			auto from = i;
+			if ( next ( data, size, i ) == invalid ) {
+				result.append ( source, copied, from - copied );
+				result.append ( "\xEF\xBF\xBD" );
+				copied = i;
+			}
+		}
+	}
+	result.append ( source, copied, size - copied );
+	return result;
+}
+
+template void utf8To16 ( std::string_view source, std::basic_string<char16_t>& result );
+template void utf8To16 ( std::string_view source, std::basic_string<wchar_t>& result );
+template void utf8To32 ( std::string_view source, std::basic_string<char32_t>& result );
+template void utf16To8 ( std::basic_string_view<char16_t> source, std::string& result );
+template void utf16To8 ( std::basic_string_view<wchar_t> source, std::string& result );
+template void utf32To8 ( std::basic_string_view<char32_t> source, std::string& result );
+template void utf16To32 ( std::basic_string_view<char16_t> source, std::basic_string<char32_t>& result );
+template void utf16To32 ( std::basic_string_view<wchar_t> source, std::basic_string<char32_t>& result );
+template void utf32To16 ( std::basic_string_view<char32_t> source, std::basic_string<char16_t>& result );
+template void utf32To16 ( std::basic_string_view<char32_t> source, std::basic_string<wchar_t>& result );
+#ifndef _WINDOWS
+template void utf8To16 ( std::string_view source, std::basic_string<WCHAR_T>& result );
+template void utf8To32 ( std::string_view source, std::basic_string<wchar_t>& result );
+template void utf16To8 ( std::basic_string_view<WCHAR_T> source, std::string& result );
+template void utf32To8 ( std::basic_string_view<wchar_t> source, std::string& result );
+template void utf16To32 ( std::basic_string_view<WCHAR_T> source, std::basic_string<wchar_t>& result );
+template void utf16To32 ( std::basic_string_view<char16_t> source, std::basic_string<wchar_t>& result );
+template void utf32To16 ( std::basic_string_view<wchar_t> source, std::basic_string<char16_t>& result );
+template void utf32To16 ( std::basic_string_view<wchar_t> source, std::basic_string<WCHAR_T>& result );
+#endif
+}
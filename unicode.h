@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+// Validating transcoding between UTF-8, UTF-16 and UTF-32. Malformed input never throws: every maximal
+// invalid subsequence becomes U+FFFD, as browsers do. UTF-16 here means code units in any 16 or 32-bit
+// type, the way 1C strings are kept in wchar_t, UTF-32 means code points in any 32-bit type
+namespace unicode {
+constexpr char32_t replacement { 0xFFFD };
+
+template <typename Unit>
+void utf8To16 ( std::string_view source, std::basic_string<Unit>& result );
+template <typename Unit>
+void utf8To32 ( std::string_view source, std::basic_string<Unit>& result );
+
+// Units above 0xFFFF are taken as code points, so wchar_t text from either side is encoded right
+template <typename Unit>
+void utf16To8 ( std::basic_string_view<Unit> source, std::string& result );
+template <typename Unit>
+void utf32To8 ( std::basic_string_view<Unit> source, std::string& result );
+
+template <typename From, typename To>
+void utf16To32 ( std::basic_string_view<From> source, std::basic_string<To>& result );
+template <typename From, typename To>
+void utf32To16 ( std::basic_string_view<From> source, std::basic_string<To>& result );
+
+bool valid ( std::string_view source );
+std::string fix ( std::string_view source );
+
+template <typename Unit>
+std::basic_string<Unit> utf8To16 ( std::string_view source ) {
+	std::basic_string<Unit> result;
+	utf8To16 ( source, result );
+	return result;
+}
+
+template <typename Unit>
+std::string utf16To8 ( std::basic_string_view<Unit> source ) {
+	std::string result;
+	utf16To8 ( source, result );
+	return result;
+}
+}
@@ -0,0 +1,185 @@
+#ifdef __linux__
+#include "walker.h"
+#include <algorithm>
+#include <dirent.h>
+#include <string>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <utility>
+
+namespace fs = std::filesystem;
+
+namespace Inotify {
+	namespace {
+		// What getdents64 fills, glibc has no wrapper before 2.30
+		struct Entry {
+			uint64_t Inode;
+			int64_t Offset;
+			unsigned short Length;
+			unsigned char Type;
+			char Name[ 1 ];
+		};
+
+		constexpr size_t BufferSize { 64 * 1024 };
+
+		unsigned char typeOf ( int Folder, const char* Name, unsigned char Type ) {
+			if ( Type != DT_UNKNOWN ) {
+				return Type;
+			}
+			// Some file systems don't fill d_type
+			struct stat status {};
+			if ( fstatat ( Folder, Name, &status, AT_SYMLINK_NOFOLLOW ) == -1 ) {
+				return DT_UNKNOWN;
+			}
+			return S_ISDIR ( status.st_mode ) ? DT_DIR : S_ISLNK ( status.st_mode ) ? DT_LNK : DT_REG;
+		}
+	}
+
+	Walker::Walker ( Visitor Visit, bool Files ) : Visit ( std::move ( Visit ) ), Files ( Files ) {
+		auto threads = std::clamp ( std::thread::hardware_concurrency (), 1u, MaxThreads );
+		for ( unsigned i = 0; i < threads; ++i ) {
+			Queues.push_back ( std::make_unique<Queue> () );
+		}
+	}
+
+	void Walker::Walk ( const fs::path& Root ) {
+		push ( 0, Root );
+		run ( 0 );
+		for ( auto& helper : Helpers ) {
+			helper.join ();
+		}
+		Helpers.clear ();
+		if ( Failure ) {
+			std::rethrow_exception ( std::exchange ( Failure, nullptr ) );
+		}
+	}
+
+	void Walker::run ( size_t Index ) {
+		std::vector<char> buffer ( BufferSize );
+		fs::path folder;
+		while ( Pending.load () ) {
+			if ( !take ( Index, folder ) ) {
+				std::unique_lock<std::mutex> lock ( Idle );
+				Sleeping.fetch_add ( 1 );
+				Work.wait ( lock, [ this ] {
+					return !Pending.load () || queued ();
+				} );
+				Sleeping.fetch_sub ( 1 );
+				continue;
+			}
+			if ( !Failed ) {
+				read ( Index, folder, buffer );
+			}
+			if ( Pending.fetch_sub ( 1 ) == 1 ) {
+				wake ();
+			}
+		}
+	}
+
+	bool Walker::take ( size_t Index, fs::path& Folder ) {
+		for ( size_t i = 0; i < Queues.size (); ++i ) {
+			auto& queue = *Queues[ ( Index + i ) % Queues.size () ];
+			std::lock_guard<std::mutex> guard ( queue.Lock );
+			if ( queue.Folders.empty () ) {
+				continue;
+			}
+			if ( i == 0 ) {
+				Folder = std::move ( queue.Folders.back () );
+				queue.Folders.pop_back ();
+			} else {
+				Folder = std::move ( queue.Folders.front () );
+				queue.Folders.pop_front ();
+			}
+			return true;
+		}
+		return false;
+	}
+
+	bool Walker::queued () {
+		for ( auto& queue : Queues ) {
+			std::lock_guard<std::mutex> guard ( queue->Lock );
+			if ( !queue->Folders.empty () ) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// A sleeper counts itself before it looks at the queues, so one that missed a folder is seen here
+	void Walker::wake () {
+		if ( Sleeping.load () ) {
+			std::lock_guard<std::mutex> guard ( Idle );
+			Work.notify_all ();
+		}
+	}
+
+	void Walker::push ( size_t Index, fs::path Folder ) {
+		Pending.fetch_add ( 1 );
+		size_t waiting;
+		{
+			auto& queue = *Queues[ Index ];
+			std::lock_guard<std::mutex> guard ( queue.Lock );
+			queue.Folders.push_back ( std::move ( Folder ) );
+			waiting = queue.Folders.size ();
+		}
+		wake ();
+		// Only the calling thread starts helpers, it alone touches the list
+		if ( Index == 0 && Helpers.empty () && waiting > Spread ) {
+			for ( size_t i = 1; i < Queues.size (); ++i ) {
+				Helpers.emplace_back ( &Walker::run, this, i );
+			}
+		}
+	}
+
+	void Walker::read ( size_t Index, const fs::path& Folder, std::vector<char>& Buffer ) {
+		auto descriptor = open ( Folder.c_str (), O_RDONLY | O_DIRECTORY | O_CLOEXEC );
+		if ( descriptor == -1 ) {
+			return;
+		}
+		std::vector<std::string> folders, files;
+		while ( true ) {
+			auto size = syscall ( SYS_getdents64, descriptor, Buffer.data (), Buffer.size () );
+			if ( size <= 0 ) {
+				break;
+			}
+			for ( long offset = 0; offset < size; ) {
+				auto entry = reinterpret_cast<const Entry*> ( Buffer.data () + offset );
+				offset += entry->Length;
+				auto name = entry->Name;
+				if ( name[ 0 ] == '.' && ( name[ 1 ] == '\0' || ( name[ 1 ] == '.' && name[ 2 ] == '\0' ) ) ) {
+					continue;
+				}
+				auto type = typeOf ( descriptor, name, entry->Type );
+				if ( type == DT_DIR ) {
+					folders.emplace_back ( name );
+				} else if ( Files ) {
+					files.emplace_back ( name );
+				}
+			}
+		}
+		close ( descriptor );
+		if ( !visit ( Folder, true ) ) {
+			return;
+		}
+		for ( auto& name : files ) {
+			visit ( Folder / name, false );
+		}
+		for ( auto& name : folders ) {
+			push ( Index, Folder / name );
+		}
+	}
+
+	bool Walker::visit ( const fs::path& Path, bool Folder ) {
+		try {
+			return Visit ( Path, Folder );
+		} catch ( ... ) {
+			if ( !Failed.exchange ( true ) ) {
+				Failure = std::current_exception ();
+			}
+			return false;
+		}
+	}
+}
+#endif
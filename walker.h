@@ -0,0 +1,63 @@
+#ifndef __walker_h__
+#define __walker_h__
+#ifdef __linux__
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Inotify {
+	// Walks a tree with getdents64, taking the type of every entry from d_type instead of a stat. Each thread
+	// takes the newest folder of its own queue and steals the oldest of the others. The walk starts on the
+	// calling thread, helpers join once enough folders wait, so a small tree costs no threads. Symbolic
+	// links are reported as files and never followed
+	class Walker {
+	public:
+		// Called from several threads at once, for a folder once it is read and closed, so a watch added
+		// there sees no events of the walk itself, then for its files. False for a folder skips what is
+		// in it. The first exception stops the walk and Walk throws it
+		using Visitor = std::function<bool ( const std::filesystem::path& Path, bool Folder )>;
+
+		// Files are reported only when asked, the others are skipped without making their paths
+		Walker ( Visitor Visit, bool Files );
+		Walker ( const Walker& ) = delete;
+		Walker& operator= ( const Walker& ) = delete;
+		void Walk ( const std::filesystem::path& Root );
+	private:
+		struct Queue {
+			std::mutex Lock;
+			std::deque<std::filesystem::path> Folders;
+		};
+
+		// Folders waiting in the queue of the calling thread before helpers are started
+		static constexpr size_t Spread { 16 };
+		static constexpr unsigned MaxThreads { 8 };
+		const Visitor Visit;
+		const bool Files;
+		std::vector<std::unique_ptr<Queue>> Queues;
+		std::vector<std::thread> Helpers;
+		std::atomic<size_t> Pending { 0 };
+		// Threads with nothing to take sleep here until a folder is pushed or the walk ends
+		std::mutex Idle;
+		std::condition_variable Work;
+		std::atomic<size_t> Sleeping { 0 };
+		std::atomic<bool> Failed { false };
+		std::exception_ptr Failure;
+
+		void run ( size_t Index );
+		bool take ( size_t Index, std::filesystem::path& Folder );
+		bool queued ();
+		void wake ();
+		void push ( size_t Index, std::filesystem::path Folder );
+		void read ( size_t Index, const std::filesystem::path& Folder, std::vector<char>& Buffer );
+		bool visit ( const std::filesystem::path& Path, bool Folder );
+	};
+}
+#endif
+#endif
@@ -7,22 +7,36 @@
 #include <filesystem>
 #endif
 #include "watcher.h"
+#include "json.h"
 
-Watcher::Watcher () : Extender ( L"Watcher" ), Active ( false ), Paused ( false ), Thread ( nullptr ) {
-	methods.AddProcedure ( L"Start", L"Старт", 1, [ & ] ( tVariant* Params ) {
-		watch ( Params );
-		return true;
-	} );
-	methods.AddProcedure ( L"Pause", L"Пауза", 0, [ & ] ( tVariant* Params ) {
-		return pause ();
-	} );
-	methods.AddProcedure ( L"Resume", L"Продолжать", 0, [ & ] ( tVariant* Params ) {
-		return resume ();
-	} );
-	methods.AddProcedure ( L"Stop", L"Стоп", 0, [ & ] ( tVariant* Params ) {
-		stopWatching ();
-		return true;
-	} );
+Watcher::Watcher ()
+		: Extender ( L"Watcher", listMethods (), listProperties () ), Active ( false ), Paused ( false ), Thread ( nullptr ),
+		  Changes ( [ this ] ( Debouncer::Change Net, bool Folder, const Debouncer::Text& Path ) {
+			  Post ( Chars::ToView ( Observer::changeToName ( Net, Folder ) ), Path );
+		  } ) {}
+
+Extender::Methods Watcher::listMethods () {
+	static constexpr auto list = table (
+			procedure<&Watcher::watch> ( L"Start", L"Старт", 1 ),
+			procedure<&Watcher::pause> ( L"Pause", L"Пауза", 0 ),
+			procedure<&Watcher::resume> ( L"Resume", L"Продолжать", 0 ),
+			procedure<&Watcher::stopWatching> ( L"Stop", L"Стоп", 0 ) );
+	return list;
+}
+
+Extender::Properties Watcher::listProperties () {
+	static constexpr auto list = fields (
+			number<&Watcher::BufferSize, 4096, 16 << 20> ( L"BufferSize", L"РазмерБуфера" ),
+			text<&Watcher::Ignore, &Watcher::validList> ( L"Ignore", L"Игнорировать" ),
+			flag<&Watcher::WholeTree> ( L"WholeTree", L"ВсёДерево" ),
+			number<&Watcher::DebounceWindow, 0, Debouncer::MaxWindow> ( L"DebounceWindow", L"ОкноСклейки" ) );
+	return list;
+}
+
+bool Watcher::validList ( std::wstring_view List ) {
+	std::vector<std::wstring> items;
+	bool json;
+	return JSON::parseList ( List, items, json );
 }
 
 Watcher::~Watcher () {
@@ -38,6 +52,8 @@ void Watcher::stopWatching () {
 		CancelIoEx ( FolderID, nullptr );
 		CloseHandle ( FolderID );
 #endif
+		// The observer may still report what it read before the stop, the debouncer drops it from here on
+		Changes.Stop ();
 		Thread->detach ();
 		delete Thread;
 		Thread = nullptr;
@@ -51,20 +67,36 @@ void Watcher::watch ( tVariant* Params ) {
 
 void Watcher::startWatching ( tVariant* Params ) {
 	std::wstring folder { Chars::WCHARToWide ( Params->pwstrVal ) };
-	Thread = new std::thread ( startObserver, this, folder, baseConnector );
+#ifdef __linux__
+	std::vector<std::wstring> ignored;
+	bool json;
+	JSON::parseList ( std::wstring_view ( Ignore ), ignored, json );
+	Notifier.IgnoreFolders.clear ();
+	for ( auto& part : ignored ) {
+		if ( !part.empty () ) {
+			Notifier.IgnoreFolders.push_back ( Chars::WideToString ( part ) );
+		}
+	}
+	Notifier.Resize ( static_cast<size_t> ( BufferSize.load () ) );
+	Notifier.WholeTree = WholeTree;
+#endif
+	Changes.Start ();
+	Thread = new std::thread ( startObserver, this, folder );
 }
 
-void Watcher::startObserver ( Watcher* Parent, const std::wstring& Folder, IAddInDefBase* Connector ) {
-	Observer resident { Parent, Folder.data (), Connector };
+void Watcher::startObserver ( Watcher* Parent, const std::wstring& Folder ) {
+	Observer resident { Parent, Folder.data () };
 	resident.Start ();
 }
 
-Watcher::Observer::Observer ( Watcher* Parent, const wchar_t* Folder, IAddInDefBase* Connector )
-		: Parent ( Parent ), Folder ( Folder ), Connector ( Connector ) {}
+Watcher::Observer::Observer ( Watcher* Parent, const wchar_t* Folder )
+		: Parent ( Parent ), Folder ( Folder ) {}
 
 void Watcher::Observer::Start () {
+	Tracer::Label ( "Watcher" );
+	Accounting::Scope account ( Parent->Background );
 #if _WIN32
-	Buffer.resize ( watcherBuffer );
+	Buffer.resize ( static_cast<size_t> ( Parent->BufferSize.load () ) );
 	auto folderID = CreateFileW ( Folder.c_str (), FILE_LIST_DIRECTORY,
 								  FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
 								  nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr );
@@ -85,6 +117,7 @@ void Watcher::Observer::observing () const {
 		if ( Parent->Paused ) {
 			return;
 		}
+		Tracer::Span span ( L"Event", "watcher" );
 		sendMessage ( &notification );
 	};
 	auto events = { Action::create,
@@ -105,8 +138,8 @@ void Watcher::Observer::observing () const {
 	};
 	auto& runner = Parent->Notifier;
 	try {
-		runner.Watch ( Folder );
 		runner.Subscribe ( events, handler );
+		runner.Watch ( Folder );
 	} catch ( std::exception& E ) {
 		Parent->SendError ( E.what () );
 	}
@@ -132,6 +165,7 @@ void Watcher::Observer::observing () {
 	while ( Parent->Active ) {
 		if ( ReadDirectoryChangesW ( id, data, size, true, filter, &returned, nullptr, nullptr ) ) {
 			if ( !Parent->Paused ) {
+				Tracer::Span span ( L"Events", "watcher" );
 				sendMessage ();
 			}
 		}
@@ -141,8 +175,9 @@ void Watcher::Observer::observing () {
 
 #ifdef __linux__
 void Watcher::Observer::sendMessage ( const Inotify::Notification* Notification ) const {
-	Connector->ExternalEvent ( Parent->ExtensionID, actionToName ( Notification->Event ),
-							   Chars::ToWCHAR ( Notification->File.string ().data () ).get () );
+	auto file = Chars::ToWCHAR ( Notification->File.string ().data () );
+	report ( actionToName ( Notification->Event ), actionToChange ( Notification->Event ), Notification->Directory,
+			 Chars::ToView ( file.get () ) );
 }
 
 bool Watcher::Observer::hasEvent ( const Inotify::Action& Source, const Inotify::Action& Event ) {
@@ -153,7 +188,8 @@ bool Watcher::Observer::hasEvent ( const Inotify::Action& Source, const Inotify:
 void Watcher::Observer::sendMessage ( DWORD Offset ) {
 	info = reinterpret_cast<FILE_NOTIFY_INFORMATION*>( &Buffer [ Offset ] );
 	File = Folder / std::wstring ( info->FileName, 0, info->FileNameLength / sizeof ( wchar_t ) );
-	Connector->ExternalEvent ( Parent->ExtensionID, actionToName (), File.c_str () );
+	auto directory = std::filesystem::is_directory ( File );
+	report ( actionToName ( directory ), actionToChange (), directory, Chars::ToView ( File.c_str () ) );
 	if ( info->NextEntryOffset ) sendMessage ( Offset + info->NextEntryOffset );
 }
 #endif
@@ -185,9 +221,25 @@ const WCHAR_T* Watcher::Observer::actionToName ( const Inotify::Action& Event )
 	return nullptr;
 }
 
+std::optional<Debouncer::Change> Watcher::Observer::actionToChange ( const Inotify::Action& Event ) {
+	using namespace Inotify;
+	if ( hasEvent ( Event, Action::movedFrom ) )
+		return Debouncer::Change::RenamedOld;
+	if ( hasEvent ( Event, Action::movedTo ) )
+		return Debouncer::Change::RenamedNew;
+	if ( hasEvent ( Event, Action::create ) )
+		return Debouncer::Change::Added;
+	if ( hasEvent ( Event, Action::remove ) )
+		return Debouncer::Change::Removed;
+	if ( hasEvent ( Event, Action::removeSelf ) )
+		return std::nullopt;
+	if ( hasEvent ( Event, Action::modify ) )
+		return Debouncer::Change::Changed;
+	return std::nullopt;
+}
+
 #elif _WIN32
-const wchar_t* Watcher::Observer::actionToName () const {
-	auto Directory = std::filesystem::is_directory ( File );
+const wchar_t* Watcher::Observer::actionToName ( bool Directory ) const {
 	switch ( info->Action ) {
 		case 1:
 			return Directory ? Actions::FolderAdded : Actions::Added;
@@ -202,8 +254,57 @@ const wchar_t* Watcher::Observer::actionToName () const {
 	}
 	return nullptr;
 }
+
+std::optional<Debouncer::Change> Watcher::Observer::actionToChange () const {
+	switch ( info->Action ) {
+		case 1:
+			return Debouncer::Change::Added;
+		case 2:
+			return Debouncer::Change::Removed;
+		case 3:
+			return Debouncer::Change::Changed;
+		case 4:
+			return Debouncer::Change::RenamedOld;
+		case 5:
+			return Debouncer::Change::RenamedNew;
+	}
+	return std::nullopt;
+}
 #endif
 
+// Changes wait in the debouncer while the window is set, anything else first lets out what waits for its path,
+// or everything for events about the whole watch such as an overflow or an unmount
+void Watcher::Observer::report ( const WCHAR_T* Action, std::optional<Debouncer::Change> Net, bool Folder,
+								 Chars::View Path ) const {
+	auto window = Parent->DebounceWindow.load ();
+	if ( window && Net ) {
+		Parent->Changes.Add ( Path, *Net, Folder, window );
+		return;
+	}
+	if ( Net ) {
+		Parent->Changes.Flush ( Path );
+	} else {
+		Parent->Changes.FlushAll ();
+	}
+	Parent->Post ( Chars::ToView ( Action ), Path );
+}
+
+const WCHAR_T* Watcher::Observer::changeToName ( Debouncer::Change Net, bool Folder ) {
+	switch ( Net ) {
+		case Debouncer::Change::Added:
+			return Folder ? Actions::FolderAdded : Actions::Added;
+		case Debouncer::Change::Removed:
+			return Folder ? Actions::FolderRemoved : Actions::Removed;
+		case Debouncer::Change::Changed:
+			return Folder ? Actions::FolderChanged : Actions::Changed;
+		case Debouncer::Change::RenamedOld:
+			return Folder ? Actions::FolderRenamedOld : Actions::RenamedOld;
+		case Debouncer::Change::RenamedNew:
+			return Folder ? Actions::FolderRenamedNew : Actions::RenamedNew;
+	}
+	return nullptr;
+}
+
 bool Watcher::pause () {
 	if ( !checkActivity () ) {
 		return false;
@@ -3,6 +3,8 @@
 #include <thread>
 #include <atomic>
 #include <filesystem>
+#include <optional>
+#include "debounce.h"
 #include "extender.h"
 #ifdef __linux__
 #include "inotify.h"
@@ -13,15 +15,15 @@ public:
 	Watcher ();
 	~Watcher () override;
 private:
+	static Methods listMethods ();
 	class Observer {
 	public:
 #ifdef _WIN32
-		const long watcherBuffer {
-				16380 * 2 }; // https://qualapps.blogspot.ca/2010/05/understanding-readdirectorychangesw_19.html
 		FILE_NOTIFY_INFORMATION* info;
 #endif
-		Observer ( Watcher* Parent, const wchar_t* Folder, IAddInDefBase* Connector );
+		Observer ( Watcher* Parent, const wchar_t* Folder );
 		void Start ();
+		static const WCHAR_T* changeToName ( Debouncer::Change Net, bool Folder );
 	private:
 		struct Actions {
 			static constexpr WCHAR_T Added[] = { '1', '\0' };
@@ -44,19 +46,22 @@ private:
 		Watcher* Parent;
 		std::filesystem::path Folder;
 		std::wstring File;
-		IAddInDefBase* Connector;
 		std::vector<std::byte> Buffer;
 
+		void report ( const WCHAR_T* Action, std::optional<Debouncer::Change> Net, bool Folder, Chars::View Path ) const;
 #ifdef __linux__
 		void observing () const;
 		void sendMessage ( const Inotify::Notification* Notification ) const;
 		static const WCHAR_T* actionToName ( const Inotify::Action& Event );
+		static std::optional<Debouncer::Change> actionToChange ( const Inotify::Action& Event );
 		static bool hasEvent ( const Inotify::Action& Source, const Inotify::Action& Event );
 #elif _WIN32
 		void observing ();
 		void sendMessage ( DWORD Offset = 0 );
 		[[nodiscard]]
-		const wchar_t* actionToName () const;
+		const wchar_t* actionToName ( bool Directory ) const;
+		[[nodiscard]]
+		std::optional<Debouncer::Change> actionToChange () const;
 #endif
 	};
 
@@ -68,8 +73,20 @@ private:
 	std::thread* Thread;
 	bool Active;
 	bool Paused;
+	// Bytes read from the system at once, taken by the next Start. On Windows more than 64K fails for
+	// network folders: https://qualapps.blogspot.ca/2010/05/understanding-readdirectorychangesw_19.html
+	std::atomic<long> BufferSize { 32768 };
+	// Parts of paths whose events are dropped, as a JSON array or one per line, Linux only
+	std::wstring Ignore;
+	// One fanotify mark for the whole tree when the rights allow it, Linux only
+	std::atomic<bool> WholeTree { false };
+	// Milliseconds a path has to stay quiet before its net change is sent, none for every event as it comes
+	std::atomic<long> DebounceWindow { 0 };
+	Debouncer Changes;
 
-	static void startObserver ( Watcher* Parent, const std::wstring& Folder, IAddInDefBase* Connector );
+	static Properties listProperties ();
+	static bool validList ( std::wstring_view List );
+	static void startObserver ( Watcher* Parent, const std::wstring& Folder );
 	void stopWatching ();
 	void startWatching ( tVariant* Params );
 	void watch ( tVariant* Params );